@@ -16,6 +16,6 @@ namespace Renderer {
     void drawBox(vec2 centre, vec2 dimensions, float rotation, vec3 colour, int lifetime);
     void drawCircle(vec2 centre, float radius, vec3 colour, int lifetime);
     void drawTriangle(vec2 a, vec2 b, vec2 c, vec3 colour, int lifetime);
-    void drawShape(Shape* shape, vec3 colour, int lifetime);
+    void drawShape(ShapeRef shape, vec3 colour, int lifetime);
 
 }
\ No newline at end of file
@@ -228,15 +228,15 @@ namespace Renderer {
 
     }
 
-    void drawShape(Shape* shape, vec3 colour, int lifetime) {
+    void drawShape(ShapeRef shape, vec3 colour, int lifetime) {
 
-        if (dynamic_cast<Triangle*>(shape) != nullptr) {
-            Triangle* triangle = (Triangle*) shape;
+        if (shape.type == ShapeType::TRIANGLE) {
+            Triangle* triangle = shape.triangle();
             drawTriangle(triangle->a, triangle->b, triangle->c, colour, lifetime);
         }
 
-        else if (dynamic_cast<Circle*>(shape) != nullptr) {
-            Circle* circle = (Circle*) shape;
+        else if (shape.type == ShapeType::CIRCLE) {
+            Circle* circle = shape.circle();
             drawCircle(circle->centre, circle->radius, colour, lifetime);
         }
         
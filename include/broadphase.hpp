@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include "collision.hpp"
+
+// A candidate pair of proxy ids, always stored with a < b.
+struct Pair {
+    int a;
+    int b;
+};
+
+/*
+Common interface of the broadphase structures.
+Proxies are identified by a non-negative id chosen by the caller, usually the index of the shape
+in the callers own arrays, so candidate pairs can be fed straight into the narrowphase.
+getPairs replaces the contents of pairs with every pair of proxies whose AABBs overlap,
+each exactly once and in no particular order. query appends the id of every proxy whose
+AABB overlaps the region. Overlap is tested with overlaps(AABB, AABB).
+*/
+class Broadphase {
+
+    public:
+
+        virtual ~Broadphase();
+
+        virtual void insert(int id, AABB aabb) = 0;
+        virtual void update(int id, AABB aabb) = 0;
+        virtual void remove(int id) = 0;
+
+        virtual void query(AABB region, std::vector<int>& result) = 0;
+        virtual void getPairs(std::vector<Pair>& pairs) = 0;
+
+};
+
+/*
+Proxy AABBs indexed by id, with a dense list of the live ids for iteration.
+Used by the broadphases that rebuild their structure from scratch when queried.
+*/
+class ProxyList {
+
+    public:
+
+        std::vector<int> ids;
+
+        void insert(int id, AABB aabb);
+        void update(int id, AABB aabb);
+        void remove(int id);
+
+        bool contains(int id) const;
+        AABB getAABB(int id) const;
+
+    private:
+
+        std::vector<AABB> aabbs;
+        std::vector<int> slots;
+
+};
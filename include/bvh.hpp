@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include "collision.hpp"
+
+/*
+Bounding volume hierarchy over a set of triangles that never move, such as level geometry.
+It is built once with the surface area heuristic, which in 2D weighs each split by the perimeters
+of the two halves, and stored as a flat array of nodes in depth first order, so a left child
+always directly follows its parent. The triangles are cached in leaf order, so queries only
+read and can run from several threads at once.
+
+The queries descend the hierarchy with the AABB of the shape and only call getCollision on the
+triangles in the leaves they reach. Hits are appended to results along with the index of the
+triangle in the array the hierarchy was built from. As with getCollision, the normal points
+from the triangle towards the query shape.
+*/
+class StaticBVH {
+
+    public:
+
+        StaticBVH(const Triangle* triangles, int n);
+
+        void query(AABB region, std::vector<int>& result) const;
+        void getCollisions(Circle c, std::vector<CollisionResult>& results, std::vector<int>& indices) const;
+        void getCollisions(const Triangle& t, std::vector<CollisionResult>& results, std::vector<int>& indices) const;
+
+    private:
+
+        // A leaf has a count and holds triangles [offset, offset + count).
+        // An internal node has a count of zero, and offset is the index of its right child.
+        struct Node {
+            AABB aabb;
+            int offset;
+            int count;
+        };
+
+        struct Item {
+            AABB aabb;
+            vec2 centre;
+            int index;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<TriangleCache> triangles;
+        std::vector<int> indices;
+
+        void build(std::vector<Item>& items, int start, int end, int depth);
+
+};
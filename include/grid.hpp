@@ -0,0 +1,53 @@
+#pragma once
+
+#include "broadphase.hpp"
+
+/*
+Uniform grid broadphase. Every proxy is binned into each cell its AABB touches, and a pair
+is only reported from the cell holding the minimum corner of the two AABBs overlap.
+
+A bounded grid stores its cells densely over [min, max] and clamps anything outside into
+the border cells. An unbounded grid hashes cell coordinates into a fixed number of buckets,
+so it covers any world size at the cost of occasionally sharing a bucket between cells.
+The bins are rebuilt lazily on the first query after a change.
+*/
+class Grid : public Broadphase {
+
+    public:
+
+        Grid(float cellSize, vec2 min, vec2 max);
+        Grid(float cellSize, int buckets);
+
+        void insert(int id, AABB aabb) override;
+        void update(int id, AABB aabb) override;
+        void remove(int id) override;
+
+        void query(AABB region, std::vector<int>& result) override;
+        void getPairs(std::vector<Pair>& pairs) override;
+
+    private:
+
+        struct Entry {
+            int id;
+            int x;
+            int y;
+        };
+
+        float cellSize;
+        vec2 origin;
+        int width;
+        int height;
+        int buckets;
+        bool hashed;
+        bool built;
+
+        ProxyList proxies;
+        std::vector<int> starts;
+        std::vector<int> cursors;
+        std::vector<Entry> entries;
+
+        int getCell(float value, int axis) const;
+        int getBucket(int x, int y) const;
+        void build();
+
+};
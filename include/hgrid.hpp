@@ -0,0 +1,59 @@
+#pragma once
+
+#include "broadphase.hpp"
+
+/*
+Hierarchical grid broadphase for scenes that mix very small and very large shapes.
+Level l has cells of cellSize * 2^l, and every proxy is stored once, at the first level whose
+cells are at least as large as its AABB, in the cell holding its minimum corner. Proxies larger
+than the top level are kept in the top level. All levels share one hashed set of buckets, so the
+grid covers any world size.
+
+A search on a level widens the region by the largest AABB stored there, and levels holding
+no proxies are skipped. Pairs are only looked for from the smaller proxy, on its own level
+and the levels above, which keeps the cost close to linear whatever the mix of sizes.
+The buckets are rebuilt lazily on the first query after a change.
+*/
+class HierarchicalGrid : public Broadphase {
+
+    public:
+
+        HierarchicalGrid(float cellSize, int levels, int buckets);
+
+        void insert(int id, AABB aabb) override;
+        void update(int id, AABB aabb) override;
+        void remove(int id) override;
+
+        void query(AABB region, std::vector<int>& result) override;
+        void getPairs(std::vector<Pair>& pairs) override;
+
+    private:
+
+        struct Entry {
+            int id;
+            int x;
+            int y;
+            int level;
+        };
+
+        float cellSize;
+        int levels;
+        int buckets;
+        bool built;
+
+        ProxyList proxies;
+        std::vector<float> inverses;
+        std::vector<int> counts;
+        std::vector<float> extents;
+        std::vector<int> starts;
+        std::vector<int> cursors;
+        std::vector<Entry> entries;
+        std::vector<int> found;
+
+        int getLevel(AABB aabb) const;
+        int getCell(float value, int level) const;
+        int getBucket(int x, int y, int level) const;
+        void build();
+        void search(AABB region, int level, std::vector<int>& result) const;
+
+};
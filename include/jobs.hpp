@@ -0,0 +1,101 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+/*
+Work-stealing scheduler for the parallel stages of a step. The calling thread counts as one of
+the threads, and the rest are workers started by the constructor. With one thread no workers are
+started, and every job runs on the caller in order.
+
+parallelFor(n, grain, f) splits [0, n) into chunks of grain items, where chunk k is
+[k * grain, min((k + 1) * grain, n)), and calls f(begin, end) once for each chunk.
+Chunk boundaries never depend on timing, so a caller can keep one output buffer per chunk, index
+it by begin / grain, and concatenate the buffers in order afterwards. Storage should not be
+keyed by thread instead: a thread waiting on a nested parallelFor runs other chunks meanwhile,
+so chunks of one job can interleave on a single thread.
+
+Each thread owns a deque of tasks, where a task is a range of chunks. A thread splits its task in
+half, pushing the second half onto the back of its deque, until one chunk is left to run. Idle
+threads steal from the front of other deques, so they take the largest ranges left. parallelFor
+returns once every chunk has run, and the calling thread runs tasks while it waits, so jobs may
+start other jobs. A thread with nothing to run sleeps on a condition variable rather than
+spinning. Pushing a task wakes a sleeper, and the last chunk of a job wakes the thread waiting on it.
+
+The deques are plain std::deques, each behind its own mutex, rather than lock-free deques. That
+is deliberate. A task is a range of chunks, so a job of k chunks costs about k pushes and pops
+across all threads, each next to a whole chunk of work. An uncontended lock is cheap beside that,
+and owners and thieves only meet on the same deque when it is nearly empty.
+
+parallelFor may be called from one outside thread at a time, or from inside a job.
+*/
+class JobSystem {
+
+    public:
+
+        JobSystem(int threads);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        int getThreadCount() const;
+
+        template <typename F>
+        void parallelFor(int n, int grain, const F& f) {
+            this->run(n, grain, &JobSystem::invoke<F>, &f);
+        }
+
+    private:
+
+        typedef void (*Body)(const void* context, int begin, int end);
+
+        struct Job {
+            Body body;
+            const void* context;
+            int n;
+            int grain;
+            std::atomic<int> pending;
+        };
+
+        // The chunks of a job from first up to last.
+        struct Task {
+            Job* job;
+            int first;
+            int last;
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::atomic<int> queued;
+        std::atomic<int> sleeping;
+        std::atomic<bool> stopping;
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+
+        template <typename F>
+        static void invoke(const void* context, int begin, int end) {
+            (*(const F*) context)(begin, end);
+        }
+
+        int getThread() const;
+        void run(int n, int grain, Body body, const void* context);
+        void push(int thread, Task task);
+        bool pop(int thread, Task& task);
+        bool steal(int thread, Task& task);
+        bool runOne(int thread);
+        void execute(int thread, Task task);
+        void loop(int thread);
+
+};
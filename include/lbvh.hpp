@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include "broadphase.hpp"
+#include "jobs.hpp"
+
+/*
+Linear bounding volume hierarchy broadphase, rebuilt from scratch on the first query after a change.
+Each proxy is placed on a Morton curve by the centre of its AABB, the codes are radix sorted,
+and every internal node of the hierarchy is then found independently from the sorted codes.
+The AABBs are filled in from the leaves upwards, where the second child to arrive at a node
+computes its bounds. Given a job system, which must outlive the hierarchy, every stage of the
+build and getPairs is split into chunks run on it. Without one they run on the caller.
+*/
+class LinearBVH : public Broadphase {
+
+    public:
+
+        LinearBVH();
+        LinearBVH(JobSystem* jobs);
+
+        void insert(int id, AABB aabb) override;
+        void update(int id, AABB aabb) override;
+        void remove(int id) override;
+
+        void query(AABB region, std::vector<int>& result) override;
+        void getPairs(std::vector<Pair>& pairs) override;
+
+    private:
+
+        // Internal nodes come first, followed by one leaf per proxy in Morton order.
+        // A leaf has no left child, and right is the id of its proxy.
+        struct Node {
+            AABB aabb;
+            int left;
+            int right;
+        };
+
+        JobSystem* jobs;
+        ProxyList proxies;
+        bool built;
+        int count;
+
+        std::vector<AABB> aabbs;
+        std::vector<vec2> centres;
+        std::vector<uint64_t> keys;
+        std::vector<uint64_t> swap;
+        std::vector<Node> nodes;
+        std::vector<int> parents;
+        std::unique_ptr<std::atomic<int>[]> arrivals;
+        int capacity;
+
+        std::vector<std::vector<Pair>> buffers;
+
+        template <typename F>
+        void parallelFor(int n, int grain, const F& f) {
+            if (this->jobs != nullptr) {this->jobs->parallelFor(n, grain, f);}
+            else {for (int begin = 0; begin < n; begin += grain) {f(begin, std::min(begin + grain, n));}}
+        }
+
+        int getGrain(int n) const;
+        void build();
+        void sort();
+        void link(int index);
+        void refit(int leaf);
+
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include "broadphase.hpp"
+#include "jobs.hpp"
+
+// The impulses a solver applied at a contact, and the feature of the contact they belong to.
+struct ContactImpulse {
+    unsigned int feature;
+    float normal;
+    float tangent;
+};
+
+/*
+Persistent set of candidate pairs, kept from one step to the next.
+Pairs are stored densely in pairs, with the latest narrowphase result for each pair at the
+same index in results, and are found by an open addressing hash table of the pair ids.
+Removing a pair moves the last pair into its place, so indices only hold until the next removal.
+
+The set is updated either from the full output of a broadphase each step, or from the pairs that
+began and ended overlapping, as given by SweepAndPrune::updatePairs. Each update replaces begun
+and ended with the pairs it added and removed, which mark where contacts start and stop.
+
+Pairs whose shapes are both at rest can be put to sleep. Awake pairs are kept below
+getAwakeCount() and sleeping pairs after them, and wake and sleep move a pair across. New pairs
+are awake. collide and gather only visit the awake pairs, so sleeping pairs cost nothing per step
+and keep their results and impulses. updateAwake takes only the broadphase pairs involving an
+awake shape, leaves the sleeping pairs as they are, and wakes any sleeping pair it is given.
+
+collide remembers the points defining both shapes each time it runs the narrowphase on a pair.
+If both shapes have since been moved by the same translation, to within the tolerance, the
+stored result is moved along with them instead of being recomputed. With a tolerance of zero,
+a result is only reused when both shapes are exactly where they were, or were moved by exactly
+the same translation.
+
+impulses holds the accumulated impulses of each pair's contact, also at the same index. They start
+at zero, are written by a solver, which can warm start a contact from them in the next step when
+its feature still matches, and are cleared by collide when the pair stops colliding.
+
+collide also lists the indices of the colliding pairs in colliding, in increasing order. A caller
+with its own narrowphase can get the same behaviour from reuse and gather instead. Given a
+job system, collide and gather split the pairs into chunks run in parallel. Each pair only writes its own
+entries, and each chunk gathers its colliding pairs in a buffer of its own, which are joined in
+chunk order afterwards, so the results are the same as on one thread.
+*/
+class PairManager {
+
+    public:
+
+        std::vector<Pair> pairs;
+        std::vector<CollisionResult> results;
+        std::vector<ContactImpulse> impulses;
+        std::vector<int> colliding;
+        std::vector<Pair> begun;
+        std::vector<Pair> ended;
+
+        PairManager();
+
+        void update(const std::vector<Pair>& current);
+        void update(const std::vector<Pair>& begun, const std::vector<Pair>& ended);
+        void updateAwake(const std::vector<Pair>& current);
+
+        bool add(int a, int b);
+        bool remove(int a, int b);
+        int find(int a, int b) const;
+        void clearEvents();
+
+        // Moves a pair, by index, between the awake and sleeping ranges, changing indices of others.
+        void wake(int index);
+        void sleep(int index);
+        int getAwakeCount() const;
+
+        // Runs the narrowphase over every awake pair, treating each pair as indices into shapes.
+        void collide(const ShapeRef* shapes);
+        void collide(const ShapeRef* shapes, float tolerance);
+        void collide(const ShapeRef* shapes, float tolerance, JobSystem* jobs);
+
+        // Checks whether the stored result of a pair still holds, as collide does. points holds three
+        // points for each shape, a then b: a circle's centre, the point radius to the right of it and
+        // its centre again, or a triangle's a, b and c. When the result holds it is moved with the
+        // shapes and true is returned. Otherwise the points are stored, and the caller must write
+        // the new result into results[index].
+        bool reuse(int index, const vec2* points, float tolerance);
+
+        // Lists the colliding awake pairs in colliding and clears the impulses of the rest.
+        // collide calls this itself, after running the narrowphase.
+        void gather(JobSystem* jobs);
+
+    private:
+
+        // The centre of a circle is stored with a point on its edge, and a triangle by its vertices.
+        struct Snapshot {
+            vec2 points[6];
+            bool valid;
+        };
+
+        std::vector<int> table;
+        std::vector<unsigned int> stamps;
+        std::vector<Snapshot> snapshots;
+        std::vector<std::vector<int>> buffers;
+        unsigned int stamp;
+        int shift;
+        int awakeCount;
+
+        int getHome(int a, int b) const;
+        int findSlot(int a, int b) const;
+        void grow();
+        void swapPairs(int i, int j);
+        void collideRange(const ShapeRef* shapes, float tolerance, int begin, int end);
+        void gatherRange(int begin, int end, std::vector<int>& colliding);
+
+};
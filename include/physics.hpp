@@ -0,0 +1,157 @@
+#pragma once
+
+#include "world.hpp"
+#include "jobs.hpp"
+
+/*
+Rigid body dynamics over the shapes of a World. Each shape is one body, with mass and inertia
+found from its area and density, rotating about its centroid. A density of zero makes a static
+body, which is never moved and has infinite mass.
+
+Each step applies gravity, runs the broadphase and narrowphase through the world, and resolves
+every contact with a sequential impulse solver: a fixed number of iterations, each applying a
+clamped normal and friction impulse at every contact in turn. Overlap is removed by biasing the
+normal velocity (Baumgarte stabilisation) beyond a small slop. Body state and contacts are
+stored as separate arrays of floats so the solver loops run over contiguous memory. Given a job
+system, the world runs the narrowphase on it, and the solver splits its work across it too.
+
+A circle whose centre steps inside a triangle gets a contact through the triangle's nearest edge.
+There is no continuous collision detection, though, so a body that crosses a whole shape in one
+step passes through it.
+
+Contacts are warm started: the impulses accumulated at each contact are kept with its pair, and
+applied again at the start of the next step if the contact comes from the same features of both
+shapes. Resting contacts then begin each step close to their solution, so stacks settle with
+fewer iterations.
+
+Bodies that stay still for sleepDelay seconds fall asleep, a whole island at a time. Islands are
+the groups of moving bodies joined by contacts, found each step with a union-find over the
+contacts of awake bodies. Static bodies do not join islands. Sleeping bodies get no gravity and
+are not integrated, and their contacts are not solved. Sleeping and static bodies are asleep in
+the world too, so the broadphase and narrowphase skip their pairs with each other. With a
+broadphase that updates its proxies in place, such as DynamicTree, a step then costs as much as
+the awake bodies whatever the size of the sleeping pile. A sleeping island wakes when an awake body touches any of its
+bodies, when one of its bodies is removed, or when a velocity or impulse is set on it.
+
+Contacts are coloured before solving, so that no two contacts of a colour share a moving body.
+Each contact greedily takes the lowest colour free on both of its bodies. Static bodies are
+never written by the solver and take no colours, so a floor under a pile does not force every
+contact into its own colour. A contact whose bodies have used all 24 colours between them goes
+to a last overflow range. Colours are solved in turn, and when a job system is given each
+colour is split into jobs. The contacts of a colour are independent, so results are the same
+whatever the number of threads, and deterministic.
+
+Each colour is solved in batches of SIMD lanes (see simd.hpp), one contact per lane, with the
+contact arrays loaded directly and body velocities gathered into lanes and scattered back. The
+batches perform the same operations as the scalar solver, so both give the same results unless
+the compiler fuses multiplies and adds.
+*/
+class Physics {
+
+    public:
+
+        World world;
+
+        vec2 gravity;
+        float friction;
+        float baumgarte;
+        float slop;
+        int iterations;
+        bool warmStarting;
+
+        // A body is still while its speed and angular speed are at most these.
+        bool sleeping;
+        float sleepVelocity;
+        float sleepAngularVelocity;
+        float sleepDelay;
+
+        Physics(Broadphase* broadphase, int iterations);
+        Physics(Broadphase* broadphase, int iterations, JobSystem* jobs);
+
+        Handle add(Circle circle, float density);
+        Handle add(const Triangle& triangle, float density);
+        void remove(Handle handle);
+
+        vec2 getCentre(Handle handle) const;
+        float getMass(Handle handle) const;
+        vec2 getVelocity(Handle handle) const;
+        float getAngularVelocity(Handle handle) const;
+        void setVelocity(Handle handle, vec2 velocity);
+        void setAngularVelocity(Handle handle, float angularVelocity);
+        void applyImpulse(Handle handle, vec2 impulse, vec2 point);
+
+        bool isAwake(Handle handle) const;
+        int getAwakeCount() const;
+        void wake(Handle handle);
+
+        void step(float dt);
+
+    private:
+
+        // Contact constraints, one entry per colliding pair, with A and B the world slots.
+        // The normal points from B towards A, as in CollisionResult.
+        struct Contacts {
+            std::vector<int> pair;
+            std::vector<int> a;
+            std::vector<int> b;
+            std::vector<float> normalX;
+            std::vector<float> normalY;
+            std::vector<float> aX;
+            std::vector<float> aY;
+            std::vector<float> bX;
+            std::vector<float> bY;
+            std::vector<float> normalMass;
+            std::vector<float> tangentMass;
+            std::vector<float> bias;
+            std::vector<float> normalImpulse;
+            std::vector<float> tangentImpulse;
+
+            // Contacts are sorted by colour, and colour k is the range [offsets[k], offsets[k + 1]).
+            // The last range is the overflow, for contacts that found no free colour.
+            std::vector<int> offsets;
+        };
+
+        JobSystem* jobs;
+
+        // Body state indexed by world slot.
+        std::vector<float> inverseMasses;
+        std::vector<float> inverseInertias;
+        std::vector<float> velocityX;
+        std::vector<float> velocityY;
+        std::vector<float> angularVelocities;
+        std::vector<float> sleepTimes;
+
+        // The awake bodies, and the index of each in that list, or -1 when asleep or static.
+        // Each sleeping island is a ring of bodies linked through islandNext.
+        std::vector<int> awake;
+        std::vector<int> awakeIndices;
+        std::vector<int> islandNext;
+
+        // Union-find working storage, indexed by slot.
+        std::vector<int> parents;
+        std::vector<float> islandTimes;
+
+        // Colouring working storage. Each body's mask holds the colours its contacts have taken.
+        std::vector<uint32_t> colourMasks;
+        std::vector<int> colours;
+        std::vector<int> intScratch;
+        std::vector<float> floatScratch;
+
+        Contacts contacts;
+
+        void attach(Handle handle, float mass, float inertia);
+        vec2 getSlotCentre(int slot) const;
+        void prepare(float dt);
+        void colour();
+        void solve();
+        void solveRange(int begin, int end);
+        void solveContact(int i);
+        void solveBatch(int i);
+        void store();
+        void integrate(float dt);
+        void wakeSlot(int slot);
+        void wakeTouched();
+        int findIsland(int slot);
+        void sleep(float dt);
+
+};
@@ -3,17 +3,26 @@
 #include <glm/glm.hpp>
 using glm::vec2;
 
-void rotateVector(vec2& vec, float degrees, vec2 origin);
-
-class Shape {
+class Rotation {
 
     public:
-        virtual void rotate(float degrees, vec2 origin);
-        virtual void translate(vec2 by);
+
+        float cos;
+        float sin;
+
+        explicit Rotation(float degrees);
+        Rotation(float cos, float sin);
+
+        Rotation inverse() const;
+        Rotation operator*(Rotation other) const;
+        vec2 rotate(vec2 vec) const;
 
 };
 
-class Line : public Shape {
+void rotateVector(vec2& vec, float degrees, vec2 origin);
+void rotateVector(vec2& vec, Rotation rotation, vec2 origin);
+
+class Line {
 
     public:
 
@@ -21,12 +30,18 @@ class Line : public Shape {
         vec2 end;
 
         Line(vec2 start, vec2 end);
-        void rotate(float degrees, vec2 origin) override;
-        void translate(vec2 by) override;
+        void rotate(float degrees, vec2 origin);
+        void rotate(Rotation rotation, vec2 origin);
+        void translate(vec2 by);
 
 };
 
-class Triangle : public Shape {
+struct AABB {
+    vec2 min;
+    vec2 max;
+};
+
+class Triangle {
 
     public:
 
@@ -35,16 +50,40 @@ class Triangle : public Shape {
         vec2 c;
 
         Triangle(vec2 a, vec2 b, vec2 c);
-        void rotate(float degrees, vec2 origin) override;
-        void translate(vec2 by) override;
+        void rotate(float degrees, vec2 origin);
+        void rotate(Rotation rotation, vec2 origin);
+        void translate(vec2 by);
 
-        vec2 centroid();
+        vec2 centroid() const;
+        AABB getAABB() const;
         Line left(vec2 vertex);
         Line right(vec2 vertex);
 
 };
 
-class Circle : public Shape {
+/*
+Derived data for a triangle, for callers that test the same triangle many times, such as a World
+or a StaticBVH. The vertices are stored in counter-clockwise order, and normals[i] is the outward
+unit normal of the edge from vertices[i] to vertices[(i + 1) % 3]. indices[i] says which of a, b
+and c (0, 1 or 2) vertices[i] is. The bounding circle is centred on the centroid.
+A cache is a copy taken when it is built, so build it again after the triangle moves.
+*/
+class TriangleCache {
+
+    public:
+
+        vec2 vertices[3];
+        int indices[3];
+        vec2 normals[3];
+        AABB bounds;
+        vec2 centre;
+        float radius;
+
+        explicit TriangleCache(const Triangle& triangle);
+
+};
+
+class Circle {
 
     public:
 
@@ -52,6 +91,38 @@ class Circle : public Shape {
         vec2 centre;
 
         Circle(float radius, vec2 centre);
-        void translate(vec2 by) override;
+        void rotate(float degrees, vec2 origin);
+        void rotate(Rotation rotation, vec2 origin);
+        void translate(vec2 by);
+        AABB getAABB() const;
+
+};
+
+enum class ShapeType {
+    CIRCLE,
+    TRIANGLE
+};
+
+/*
+A tagged reference to a circle or triangle. Shapes carry no vtable, so mixed shapes are
+stored as flat arrays of ShapeRefs and dispatched on the type tag instead of through RTTI.
+*/
+class ShapeRef {
+
+    public:
+
+        ShapeType type;
+        void* shape;
+
+        ShapeRef(Circle* circle);
+        ShapeRef(Triangle* triangle);
+
+        Circle* circle() const;
+        Triangle* triangle() const;
+
+        void rotate(float degrees, vec2 origin);
+        void rotate(Rotation rotation, vec2 origin);
+        void translate(vec2 by);
+        AABB getAABB() const;
 
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "broadphase.hpp"
+
+/*
+Loose quadtree broadphase over a square region of the world. Every node accepts anything whose
+centre lies in its cell, and extends half a cell past it on each side, so the node for a proxy is
+computed directly from its centre and size: the deepest level whose cells are at least as large as
+the proxy. A moving proxy stays in its node while it still fits the node's loose bounds and is
+not small enough for a deeper level, so it is only relinked, touching the counts on the path to
+the root, once it leaves them. Proxies that do not fit inside the region are held
+at the root, which is treated as unbounded.
+
+Every level is stored densely, so the depth is limited to keep the memory reasonable.
+Empty subtrees are skipped using the number of proxies below each node.
+*/
+class LooseQuadtree : public Broadphase {
+
+    public:
+
+        LooseQuadtree(vec2 min, vec2 max, int depth);
+
+        void insert(int id, AABB aabb) override;
+        void update(int id, AABB aabb) override;
+        void remove(int id) override;
+
+        void query(AABB region, std::vector<int>& result) override;
+        void getPairs(std::vector<Pair>& pairs) override;
+
+    private:
+
+        struct Proxy {
+            AABB aabb;
+            int node;
+            int next;
+            int previous;
+        };
+
+        vec2 origin;
+        float size;
+        int depth;
+
+        std::vector<int> offsets;
+        std::vector<int> heads;
+        std::vector<int> counts;
+        std::vector<Proxy> proxies;
+        std::vector<int> found;
+
+        int getNode(AABB aabb) const;
+        bool fits(int node, AABB aabb) const;
+        void link(int id, int node);
+        void unlink(int id);
+        void search(AABB region, int level, std::vector<int>& result) const;
+
+};
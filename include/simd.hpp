@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+Thin wrappers over the widest float vector available at compile time.
+Building with -mavx2 (the TRIP2D_AVX2 option) gives 8 lanes, otherwise SSE2 gives 4.
+When neither is available TRIP2D_LANES is left undefined, and callers use their scalar paths.
+Comparisons return a mask where every bit of a passing lane is set.
+*/
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+#define TRIP2D_LANES 8
+
+namespace Simd {
+
+    typedef __m256 floats;
+
+    inline floats splat(float v) {return _mm256_set1_ps(v);}
+    inline floats load(const float* p) {return _mm256_loadu_ps(p);}
+    inline void store(float* p, floats v) {_mm256_storeu_ps(p, v);}
+
+    inline floats add(floats a, floats b) {return _mm256_add_ps(a, b);}
+    inline floats sub(floats a, floats b) {return _mm256_sub_ps(a, b);}
+    inline floats mul(floats a, floats b) {return _mm256_mul_ps(a, b);}
+    inline floats div(floats a, floats b) {return _mm256_div_ps(a, b);}
+    inline floats sqrt(floats a) {return _mm256_sqrt_ps(a);}
+    inline floats min(floats a, floats b) {return _mm256_min_ps(a, b);}
+    inline floats max(floats a, floats b) {return _mm256_max_ps(a, b);}
+    inline floats abs(floats a) {return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);}
+
+    inline floats less(floats a, floats b) {return _mm256_cmp_ps(a, b, _CMP_LT_OQ);}
+    inline floats lessEqual(floats a, floats b) {return _mm256_cmp_ps(a, b, _CMP_LE_OQ);}
+    inline floats both(floats a, floats b) {return _mm256_and_ps(a, b);}
+    inline floats either(floats a, floats b) {return _mm256_or_ps(a, b);}
+    inline floats select(floats mask, floats a, floats b) {return _mm256_blendv_ps(b, a, mask);}
+    inline int bits(floats mask) {return _mm256_movemask_ps(mask);}
+
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+#define TRIP2D_LANES 4
+
+namespace Simd {
+
+    typedef __m128 floats;
+
+    inline floats splat(float v) {return _mm_set1_ps(v);}
+    inline floats load(const float* p) {return _mm_loadu_ps(p);}
+    inline void store(float* p, floats v) {_mm_storeu_ps(p, v);}
+
+    inline floats add(floats a, floats b) {return _mm_add_ps(a, b);}
+    inline floats sub(floats a, floats b) {return _mm_sub_ps(a, b);}
+    inline floats mul(floats a, floats b) {return _mm_mul_ps(a, b);}
+    inline floats div(floats a, floats b) {return _mm_div_ps(a, b);}
+    inline floats sqrt(floats a) {return _mm_sqrt_ps(a);}
+    inline floats min(floats a, floats b) {return _mm_min_ps(a, b);}
+    inline floats max(floats a, floats b) {return _mm_max_ps(a, b);}
+    inline floats abs(floats a) {return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);}
+
+    inline floats less(floats a, floats b) {return _mm_cmplt_ps(a, b);}
+    inline floats lessEqual(floats a, floats b) {return _mm_cmple_ps(a, b);}
+    inline floats both(floats a, floats b) {return _mm_and_ps(a, b);}
+    inline floats either(floats a, floats b) {return _mm_or_ps(a, b);}
+    inline floats select(floats mask, floats a, floats b) {return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));}
+    inline int bits(floats mask) {return _mm_movemask_ps(mask);}
+
+}
+
+#endif
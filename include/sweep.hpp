@@ -0,0 +1,44 @@
+#pragma once
+
+#include "pairs.hpp"
+
+/*
+Sweep and prune broadphase. The min and max of every AABB on each axis are kept in two
+persistently sorted endpoint lists. Each step the lists are re-sorted with insertion sort,
+which is close to linear when the shapes have only moved a little since the last step.
+Every swap of a min endpoint with a max endpoint is where a pair can start or stop overlapping,
+so the pair set is updated from the swaps alone instead of being recomputed.
+
+Call updatePairs once per step to get the pairs that began and ended overlapping since the
+previous call. getPairs also brings the set up to date and returns all of it, but drops the
+events, so use one or the other each step.
+Removing a proxy is linear in the number of proxies.
+*/
+class SweepAndPrune : public Broadphase {
+
+    public:
+
+        void insert(int id, AABB aabb) override;
+        void update(int id, AABB aabb) override;
+        void remove(int id) override;
+
+        void query(AABB region, std::vector<int>& result) override;
+        void getPairs(std::vector<Pair>& pairs) override;
+        void updatePairs(std::vector<Pair>& begun, std::vector<Pair>& ended);
+
+    private:
+
+        // An endpoint stores its proxy id shifted left by one, with the low bit set for a max.
+        struct Endpoint {
+            float value;
+            int data;
+        };
+
+        ProxyList proxies;
+        std::vector<Endpoint> endpoints[2];
+
+        PairManager manager;
+
+        void sort(int axis);
+
+};
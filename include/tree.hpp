@@ -0,0 +1,55 @@
+#pragma once
+
+#include "broadphase.hpp"
+
+/*
+Dynamic AABB tree broadphase. Leaves store "fat" AABBs, grown by a margin on every side, so a
+proxy that moves a little stays inside its fat AABB and update only records the new bounds.
+Once a proxy leaves its fat AABB it is removed and reinserted, choosing the sibling with the
+lowest perimeter cost, and the path back to the root is rebalanced with tree rotations.
+Pairs and queries are tested against the exact AABBs, so the output matches every other broadphase.
+*/
+class DynamicTree : public Broadphase {
+
+    public:
+
+        DynamicTree(float margin);
+
+        void insert(int id, AABB aabb) override;
+        void update(int id, AABB aabb) override;
+        void remove(int id) override;
+
+        void query(AABB region, std::vector<int>& result) override;
+        void getPairs(std::vector<Pair>& pairs) override;
+
+        int getHeight() const;
+
+    private:
+
+        struct Node {
+            AABB aabb;
+            int parent;
+            int left;
+            int right;
+            int height;
+            int id;
+        };
+
+        float margin;
+        int root;
+        int freeList;
+
+        std::vector<Node> nodes;
+        std::vector<int> leaves;
+        std::vector<int> stack;
+        std::vector<Pair> nodePairs;
+        ProxyList proxies;
+
+        int allocate();
+        void release(int index);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        void refit(int index);
+        int balance(int index);
+
+};
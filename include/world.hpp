@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include "pairs.hpp"
+
+/*
+A shape in a World. The low 22 bits are the slot of the shape, and the high 10 bits count how
+many times the slot has been reused, so a handle to a removed shape never finds its replacement.
+A slot is retired once its count is used up rather than letting it wrap around. Adding a shape
+when all 2^22 - 1 slots are taken fails and returns INVALID_HANDLE, which contains rejects.
+*/
+typedef uint32_t Handle;
+const Handle INVALID_HANDLE = 0xffffffff;
+
+/*
+Owns circles and triangles in contiguous pools, and ties them to a broadphase and a pair manager.
+Circles are stored as separate x, y and radius arrays, ready for the batched SIMD kernels, and
+triangles as separate arrays for the x and y of each vertex. Each triangle also has a cache for
+the narrowphase, which is rebuilt whenever the triangle moves.
+Removing a shape moves the last shape of its pool into its place, so the pools stay dense,
+while handles stay valid through the slot table.
+
+Shapes start awake and can be put to sleep with setAwake. Pairs of two sleeping shapes are put to
+sleep in the pair manager, and collide only asks the broadphase about the awake shapes once they
+are outnumbered, so the cost of a step follows the awake shapes rather than the whole world.
+A sleeping shape must not move, so moving one wakes it first. Two shapes that start
+overlapping while both are asleep, which only happens when they are added that way, may not be
+paired until one of them wakes.
+
+The slot of a shape is its id in the broadphase and in the pairs, and getHandle turns it back
+into a handle. A removed shape's slot is only reused after the next collide, so the pair manager
+has reported its pairs as ended first. The broadphase is not owned by the world.
+
+collide runs the narrowphase straight from the pools. Pairs whose results the pair manager cannot
+reuse are sorted into batches, one for each shape paired with circles, and each batch gathers
+its circles' columns and runs them through the SIMD kernels against that shape in one call.
+Pairs of triangles go through the scalar kernel. Given a job system, which the world does not
+own either, the batches run on it.
+*/
+class World {
+
+    public:
+
+        PairManager pairs;
+
+        World(Broadphase* broadphase);
+        World(Broadphase* broadphase, JobSystem* jobs);
+
+        Handle add(Circle circle);
+        Handle add(const Triangle& triangle);
+        void remove(Handle handle);
+        bool contains(Handle handle) const;
+
+        ShapeType getType(Handle handle) const;
+        Circle getCircle(Handle handle) const;
+        Triangle getTriangle(Handle handle) const;
+        AABB getAABB(Handle handle) const;
+
+        void translate(Handle handle, vec2 by);
+        void rotate(Handle handle, Rotation rotation, vec2 origin);
+
+        // Rotates the shape about origin and then translates it, updating the broadphase once.
+        void transform(Handle handle, Rotation rotation, vec2 origin, vec2 by);
+
+        void setAwake(Handle handle, bool awake);
+        bool isAwake(Handle handle) const;
+        int getAwakeCount() const;
+
+        int getSlot(Handle handle) const;
+        Handle getHandle(int slot) const;
+
+        // Index of the shape within its pool, which changes when other shapes are removed.
+        int getIndex(Handle handle) const;
+
+        int getCircleCount() const;
+        const float* getCircleX() const;
+        const float* getCircleY() const;
+        const float* getCircleRadii() const;
+        Handle getCircleHandle(int index) const;
+
+        int getTriangleCount() const;
+        const float* getTriangleAX() const;
+        const float* getTriangleAY() const;
+        const float* getTriangleBX() const;
+        const float* getTriangleBY() const;
+        const float* getTriangleCX() const;
+        const float* getTriangleCY() const;
+        Handle getTriangleHandle(int index) const;
+
+        // Updates pairs from the broadphase, then runs the narrowphase over them.
+        void collide();
+        void collide(float tolerance);
+
+    private:
+
+        struct Slot {
+            uint32_t generation;
+            ShapeType type;
+            int index;
+            int next;
+            int awake;
+        };
+
+        Broadphase* broadphase;
+        JobSystem* jobs;
+
+        std::vector<Slot> slots;
+        int freeList;
+        std::vector<int> released;
+        std::vector<int> awake;
+
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> radii;
+        std::vector<int> circleSlots;
+
+        std::vector<float> ax;
+        std::vector<float> ay;
+        std::vector<float> bx;
+        std::vector<float> by;
+        std::vector<float> cx;
+        std::vector<float> cy;
+        std::vector<TriangleCache> caches;
+        std::vector<int> triangleSlots;
+
+        // The circles paired with one shape, copied into columns for the SIMD kernels.
+        struct Batch {
+            std::vector<float> x;
+            std::vector<float> y;
+            std::vector<float> radii;
+            std::vector<int> pairs;
+            std::vector<CollisionResult> results;
+            std::vector<int> indices;
+        };
+
+        std::vector<Pair> candidates;
+        std::vector<int> found;
+        std::vector<int> stale;
+        std::vector<std::vector<int>> buffers;
+
+        // The stale pairs of each batch, as linked lists through links starting at heads[key].
+        std::vector<int> keys;
+        std::vector<int> heads;
+        std::vector<int> links;
+        std::vector<int> trianglePairs;
+        std::vector<Batch> batches;
+
+        int allocate(ShapeType type, int index);
+        Triangle loadTriangle(int index) const;
+        void storeTriangle(int index, const Triangle& triangle);
+        void refresh(int slot);
+        void findCandidates();
+        void dropAwake(int slot);
+        void markPairs(int slot, bool awake);
+
+        void capture(int slot, vec2* points) const;
+        void findStale(float tolerance, int begin, int end, std::vector<int>& stale);
+        void sortStale();
+        void collideBatch(int key, Batch& batch);
+        void collideTriangles(int index);
+
+};
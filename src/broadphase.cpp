@@ -0,0 +1,47 @@
+#include "broadphase.hpp"
+
+Broadphase::~Broadphase() {
+
+}
+
+void ProxyList::insert(int id, AABB aabb) {
+
+    if (id >= (int) this->slots.size()) {
+        this->slots.resize(id + 1, -1);
+        this->aabbs.resize(id + 1);
+    }
+
+    if (this->slots[id] < 0) {
+        this->slots[id] = this->ids.size();
+        this->ids.push_back(id);
+    }
+
+    this->aabbs[id] = aabb;
+
+}
+
+void ProxyList::update(int id, AABB aabb) {
+    this->aabbs[id] = aabb;
+}
+
+void ProxyList::remove(int id) {
+
+    if (!this->contains(id)) {return;}
+
+    // Swap the last id into the removed slot.
+    int slot = this->slots[id];
+    int last = this->ids.back();
+    this->ids[slot] = last;
+    this->slots[last] = slot;
+    this->ids.pop_back();
+    this->slots[id] = -1;
+
+}
+
+bool ProxyList::contains(int id) const {
+    return id >= 0 && id < (int) this->slots.size() && this->slots[id] >= 0;
+}
+
+AABB ProxyList::getAABB(int id) const {
+    return this->aabbs[id];
+}
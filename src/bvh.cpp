@@ -0,0 +1,238 @@
+#include <algorithm>
+#include "bvh.hpp"
+
+namespace {
+
+    const int BINS = 16;
+    const int LEAF_SIZE = 4;
+
+    // Beyond this depth every split is at the median, which bounds the depth of any tree
+    // and lets queries use a fixed size stack.
+    const int MEDIAN_DEPTH = 32;
+    const int STACK_SIZE = 64;
+
+    AABB combine(AABB a, AABB b) {
+        return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+    }
+
+    float perimeter(AABB a) {
+        vec2 size = a.max - a.min;
+        return 2.0f * (size.x + size.y);
+    }
+
+    struct Bin {
+        AABB aabb;
+        int count;
+    };
+
+}
+
+StaticBVH::StaticBVH(const Triangle* triangles, int n) {
+
+    std::vector<Item> items(n);
+    for (int i = 0; i < n; i++) {
+        AABB aabb = triangles[i].getAABB();
+        items[i] = {aabb, (aabb.min + aabb.max) * 0.5f, i};
+    }
+
+    this->nodes.reserve(std::max(2 * n - 1, 1));
+    if (n > 0) {this->build(items, 0, n, 0);}
+
+    // Cache the triangles in leaf order.
+    this->triangles.reserve(n);
+    this->indices.reserve(n);
+    for (const Item& item : items) {
+        this->triangles.push_back(TriangleCache(triangles[item.index]));
+        this->indices.push_back(item.index);
+    }
+
+}
+
+void StaticBVH::build(std::vector<Item>& items, int start, int end, int depth) {
+
+    int index = this->nodes.size();
+    this->nodes.push_back({});
+
+    AABB aabb = items[start].aabb;
+    AABB centres = {items[start].centre, items[start].centre};
+    for (int i = start + 1; i < end; i++) {
+        aabb = combine(aabb, items[i].aabb);
+        centres = combine(centres, {items[i].centre, items[i].centre});
+    }
+
+    int count = end - start;
+    this->nodes[index] = {aabb, start, count};
+    if (count == 1) {return;}
+
+    // Split along the axis where the centres are most spread out.
+    vec2 extent = centres.max - centres.min;
+    int axis = extent.x >= extent.y ? 0 : 1;
+    if (extent[axis] <= 0.0f) {
+        if (count <= LEAF_SIZE) {return;}
+        depth = MEDIAN_DEPTH;
+    }
+
+    int middle = start + count / 2;
+
+    if (depth < MEDIAN_DEPTH) {
+
+        // Bin the items by their centre.
+        Bin bins[BINS];
+        for (Bin& bin : bins) {bin.count = 0;}
+        float scale = BINS / extent[axis];
+        for (int i = start; i < end; i++) {
+            int b = std::min((int) ((items[i].centre[axis] - centres.min[axis]) * scale), BINS - 1);
+            bins[b].aabb = bins[b].count == 0 ? items[i].aabb : combine(bins[b].aabb, items[i].aabb);
+            bins[b].count++;
+        }
+
+        // Sweep from the right to find the cost of every right half.
+        float rightCosts[BINS];
+        AABB right = {};
+        int rightCount = 0;
+        for (int b = BINS - 1; b > 0; b--) {
+            if (bins[b].count > 0) {
+                right = rightCount == 0 ? bins[b].aabb : combine(right, bins[b].aabb);
+                rightCount += bins[b].count;
+            }
+            rightCosts[b] = rightCount == 0 ? 0.0f : perimeter(right) * rightCount;
+        }
+
+        // Then sweep from the left to find the cheapest split.
+        int bestSplit = -1;
+        float bestCost = 0.0f;
+        AABB left = {};
+        int leftCount = 0;
+        for (int b = 0; b < BINS - 1; b++) {
+            if (bins[b].count > 0) {
+                left = leftCount == 0 ? bins[b].aabb : combine(left, bins[b].aabb);
+                leftCount += bins[b].count;
+            }
+            if (leftCount == 0 || leftCount == count) {continue;}
+            float cost = perimeter(left) * leftCount + rightCosts[b + 1];
+            if (bestSplit < 0 || cost < bestCost) {
+                bestSplit = b;
+                bestCost = cost;
+            }
+        }
+
+        // Keep small ranges as a leaf when splitting them would cost more than testing every triangle.
+        if (count <= LEAF_SIZE && (bestSplit < 0 || bestCost >= perimeter(aabb) * count)) {return;}
+
+        if (bestSplit >= 0) {
+            float origin = centres.min[axis];
+            middle = std::partition(items.begin() + start, items.begin() + end, [axis, origin, scale, bestSplit](const Item& item) {
+                return std::min((int) ((item.centre[axis] - origin) * scale), BINS - 1) <= bestSplit;
+            }) - items.begin();
+        }
+
+    }
+
+    // Fall back to the median when the heuristic found nothing to split.
+    if (depth >= MEDIAN_DEPTH || middle == start || middle == end) {
+        middle = start + count / 2;
+        std::nth_element(items.begin() + start, items.begin() + middle, items.begin() + end, [axis](const Item& a, const Item& b) {
+            return a.centre[axis] < b.centre[axis];
+        });
+    }
+
+    this->build(items, start, middle, depth + 1);
+    this->nodes[index].offset = this->nodes.size();
+    this->nodes[index].count = 0;
+    this->build(items, middle, end, depth + 1);
+
+}
+
+void StaticBVH::query(AABB region, std::vector<int>& result) const {
+
+    if (this->nodes.empty()) {return;}
+
+    int stack[STACK_SIZE];
+    int size = 0;
+    stack[size++] = 0;
+
+    while (size > 0) {
+
+        int index = stack[--size];
+        const Node& node = this->nodes[index];
+        if (!overlaps(node.aabb, region)) {continue;}
+
+        if (node.count > 0) {
+            for (int i = node.offset; i < node.offset + node.count; i++) {
+                if (overlaps(this->triangles[i].bounds, region)) {result.push_back(this->indices[i]);}
+            }
+            continue;
+        }
+
+        // The left child directly follows its parent.
+        stack[size++] = node.offset;
+        stack[size++] = index + 1;
+
+    }
+
+}
+
+void StaticBVH::getCollisions(Circle c, std::vector<CollisionResult>& results, std::vector<int>& indices) const {
+
+    if (this->nodes.empty()) {return;}
+
+    AABB region = c.getAABB();
+    int stack[STACK_SIZE];
+    int size = 0;
+    stack[size++] = 0;
+
+    while (size > 0) {
+
+        int index = stack[--size];
+        const Node& node = this->nodes[index];
+        if (!overlaps(node.aabb, region)) {continue;}
+
+        if (node.count > 0) {
+            for (int i = node.offset; i < node.offset + node.count; i++) {
+                CollisionResult result = getCollision(c, this->triangles[i]);
+                if (!result.colliding) {continue;}
+                results.push_back(result);
+                indices.push_back(this->indices[i]);
+            }
+            continue;
+        }
+
+        stack[size++] = node.offset;
+        stack[size++] = index + 1;
+
+    }
+
+}
+
+void StaticBVH::getCollisions(const Triangle& t, std::vector<CollisionResult>& results, std::vector<int>& indices) const {
+
+    if (this->nodes.empty()) {return;}
+
+    TriangleCache cache = TriangleCache(t);
+    AABB region = cache.bounds;
+    int stack[STACK_SIZE];
+    int size = 0;
+    stack[size++] = 0;
+
+    while (size > 0) {
+
+        int index = stack[--size];
+        const Node& node = this->nodes[index];
+        if (!overlaps(node.aabb, region)) {continue;}
+
+        if (node.count > 0) {
+            for (int i = node.offset; i < node.offset + node.count; i++) {
+                CollisionResult result = getCollision(cache, this->triangles[i]);
+                if (!result.colliding) {continue;}
+                results.push_back(result);
+                indices.push_back(this->indices[i]);
+            }
+            continue;
+        }
+
+        stack[size++] = node.offset;
+        stack[size++] = index + 1;
+
+    }
+
+}
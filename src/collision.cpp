@@ -1,524 +1,475 @@
 #include <cmath>
 #include <limits>
-#include <vector>
 #include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/geometric.hpp>
 #include "collision.hpp"
 
-#include <iostream>
-
 namespace {
 
-    bool below(vec2 point, vec2 start, vec2 end) {
+    // Checks whether the bounding boxes of two triangles overlap by more than their edges.
+    bool boundsOverlap(AABB a, AABB b) {
+        return a.min.x < b.max.x && a.max.x > b.min.x && a.min.y < b.max.y && a.max.y > b.min.y;
+    }
 
-        if (start.x == end.x) {return point.y < start.y;}
+    // Checks whether the circle reaches the bounding box.
+    bool boundsOverlap(const Circle& c, AABB bounds) {
+        return c.centre.x >= bounds.min.x - c.radius && c.centre.x <= bounds.max.x + c.radius && c.centre.y >= bounds.min.y - c.radius && c.centre.y <= bounds.max.y + c.radius;
+    }
 
-        float m = (end.y - start.y) / (end.x - start.x);
-        float y = m * (point.x - start.x) + start.y;
+    // Checks whether the bounding boxes and bounding circles of two triangles overlap.
+    bool boundsOverlap(const TriangleCache& a, const TriangleCache& b) {
 
-        return point.y < y;
+        if (!boundsOverlap(a.bounds, b.bounds)) {return false;}
 
-    }
+        float sumRadii = a.radius + b.radius;
+        vec2 distance = a.centre - b.centre;
+        return glm::dot(distance, distance) <= sumRadii * sumRadii;
 
-    bool above(vec2 point, vec2 start, vec2 end) {
+    }
 
-        if (start.x == end.x) {return point.y > start.y;}
+    // Checks whether the circle reaches the triangles aabb and bounding circle.
+    bool boundsOverlap(const Circle& c, const TriangleCache& t) {
 
-        float m = (end.y - start.y) / (end.x - start.x);
-        float y = m * (point.x - start.x) + start.y;
+        if (!boundsOverlap(c, t.bounds)) {return false;}
 
-        return point.y > y;
+        float sumRadii = c.radius + t.radius;
+        vec2 distance = c.centre - t.centre;
+        return glm::dot(distance, distance) <= sumRadii * sumRadii;
 
     }
 
-    bool intersects(vec2 point, Triangle localised) {
-        return above(point, localised.a, localised.b) && below(point, localised.a, localised.c) && below(point, localised.c, localised.b);
+    // Gets how far the incident triangle reaches past the given edge of the reference triangle, against its outward normal.
+    float getOverlap(const TriangleCache& reference, const TriangleCache& incident, int edge) {
+        vec2 axis = reference.normals[edge];
+        float a = glm::dot(incident.vertices[0], axis);
+        float b = glm::dot(incident.vertices[1], axis);
+        float c = glm::dot(incident.vertices[2], axis);
+        return glm::dot(reference.vertices[edge], axis) - std::min(std::min(a, b), c);
     }
 
-    vec2 getNormal(vec2 start, vec2 end) {
-        vec2 result = end - start;
-        rotateVector(result, 90.0f, vec2(0.0f, 0.0f));
-        return glm::normalize(result);
+    // Checks whether any edge normal of the reference triangle separates the two triangles.
+    bool separates(const TriangleCache& reference, const TriangleCache& incident) {
+        for (int i = 0; i < 3; i++) {
+            if (getOverlap(reference, incident, i) <= 0.0f) {return true;}
+        }
+        return false;
     }
 
-    /*
-    Gets distance from aStart to the intersection of the lines A and B.
-    This function assumes that we are working with infinitely long lines, and NOT line segments.
-    To determine whether two line segments intersect, use: 
+    struct Penetration {
+        bool separated;
+        float overlap;
+        vec2 normal;
+        int edge;
+    };
 
-        intersects(vec2 aStart, vec2 aEnd, vec2 bStart, vec2 bEnd);
+    /*
+    Tests the outward edge normals of the reference triangle as separating axes.
+    If any axis separates the triangles, the result is marked as separated.
+    Otherwise the axis with the smallest overlap is returned, with the index of its edge. Its normal
+    is the direction the incident triangle must move to resolve the overlap.
+    For convex shapes, the outward direction of every edge normal is enough to find the minimum.
     */
-    float getDistance(vec2 aStart, vec2 aEnd, vec2 bStart, vec2 bEnd) {
-
-        // If either line is vertical, rotate the problem 45 degrees.
-        // Since we are solving for distance, direction does not need to be preserved.
-        if (aStart.x == aEnd.x || bStart.x == bEnd.x) {
-            rotateVector(aStart, 45.0f, vec2(0.0f, 0.0f));
-            rotateVector(aEnd, 45.0f, vec2(0.0f, 0.0f));
-            rotateVector(bStart, 45.0f, vec2(0.0f, 0.0f));
-            rotateVector(bEnd, 45.0f, vec2(0.0f, 0.0f));
-        }
-
-        // y = ax + b
-        float a = (aEnd.y - aStart.y) / (aEnd.x - aStart.x);
-        float b = aStart.y - a * aStart.x;
-        
-        // y = cx + d
-        float c = (bEnd.y - bStart.y) / (bEnd.x - bStart.x);
-        float d = bStart.y - c * bStart.x;
+    Penetration getPenetration(const TriangleCache& reference, const TriangleCache& incident) {
 
-        // ax + b = cx + d: solve for x
-        float x = (d - b) / (a - c);
+        Penetration result = {false, std::numeric_limits<float>::max(), vec2(0.0f, 0.0f), 0};
 
-        // plug x into ax + b
-        float y = a * x + b;
+        for (int i = 0; i < 3; i++) {
+            float overlap = getOverlap(reference, incident, i);
+            if (overlap <= 0.0f) {return {true, 0.0f, vec2(0.0f, 0.0f), 0};}
+            if (overlap < result.overlap) {result = {false, overlap, reference.normals[i], i};}
+        }
 
-        // Now that we have the point, compute the distance between points.
-        vec2 point = vec2(x, y);
-        return glm::distance(aStart, point);
+        return result;
 
     }
 
-    float getPerpendicularDistance(vec2 point, vec2 start, vec2 end) {
-
-        // If the line is vertical, rotate the problem 45 degrees.
-        // Since we are solving for distance, direction does not need to be preserved.
-        if (start.x == end.x) {
-            rotateVector(point, 45.0f, vec2(0.0f, 0.0f));
-            rotateVector(start, 45.0f, vec2(0.0f, 0.0f));
-            rotateVector(end, 45.0f, vec2(0.0f, 0.0f));
-        }
+    // Gets the index of the vertex of the triangle that is furthest along the given direction.
+    int getSupport(const TriangleCache& t, vec2 direction) {
+        float a = glm::dot(t.vertices[0], direction);
+        float b = glm::dot(t.vertices[1], direction);
+        float c = glm::dot(t.vertices[2], direction);
+        if (a >= b && a >= c) {return 0;}
+        if (b >= c) {return 1;}
+        return 2;
+    }
 
-        // Get the line in form y = mx + b
-        float gradient = (end.y - start.y) / (end.x - start.x);
-        float intercept = start.y - gradient * start.x;
+    // The features of a cached vertex, and of the cached edge from vertices[edge] to the next vertex.
+    unsigned int getVertexFeature(const TriangleCache& t, int vertex) {
+        return FEATURE_VERTEX | t.indices[vertex];
+    }
 
-        // Get the line in general form ax + by + c = 0
-        float a = 1.0f;
-        float b = -gradient;
-        float c = -intercept;
+    unsigned int getEdgeFeature(const TriangleCache& t, int edge) {
+        return FEATURE_EDGE | t.indices[(edge + 2) % 3];
+    }
 
-        // Use perpendicular distance formula.
-        float distance = fabsf(a * point.x + b * point.y + c) / sqrtf(a * a + b * b);
-        return distance;
+    // Swaps the roles of the two shapes in a result.
+    CollisionResult flip(CollisionResult result) {
+        result.normal = -result.normal;
+        result.feature = (result.feature & 0xff) << 8 | (result.feature >> 8 & 0xff);
+        return result;
+    }
 
+    bool touchesCorner(const Circle& c, vec2 p) {
+        vec2 difference = c.centre - p;
+        return glm::dot(difference, difference) < c.radius * c.radius;
     }
 
-    struct TriangleLocalisation {
-        Triangle triangle;
-        float rotation;
-        vec2 translation;
-    };
+    /*
+    Moves the circle into the space of the edge, where start is at the origin and end lies on the positive x axis.
+    End is replaced by its position in that space, and the rotation that was applied is returned.
+    */
+    Rotation localiseEdge(Circle& c, vec2 start, vec2& end) {
 
-    TriangleLocalisation localise(Triangle t) {
+        // Translate the space to the origin.
+        c.centre -= start;
+        end -= start;
 
-        // Keep track of the translation and rotation.
-        vec2 translation = vec2(0.0f, 0.0f);
-        float rotation = 0.0f;
+        // Rotate the space such that end is on the positive x axis.
+        vec2 direction = glm::normalize(end);
+        Rotation rotation = Rotation(direction.x, -direction.y);
+        rotateVector(c.centre, rotation, vec2(0.0f, 0.0f));
+        rotateVector(end, rotation, vec2(0.0f, 0.0f));
 
-        // Find the longest side length
-        vec2 ab = t.b - t.a;
-        vec2 ac = t.c - t.a;
-        vec2 bc = t.c - t.b;
+        return rotation;
 
-        float ab2 = glm::dot(ab, ab);
-        float ac2 = glm::dot(ac, ac);
-        float bc2 = glm::dot(bc, bc);
-        float longest = std::max(std::max(ab2, ac2), bc2);
+    }
 
-        // If AB is not the longest, swap the vertices, such that AB is the longest.
-        if (ac2 == longest) {
-            vec2 tmp = t.b;
-            t.b = t.c;
-            t.c = tmp;
-        }
+    /*
+    In edge space, the circle touches the edge when its centre is above the edge by less than the radius,
+    and within the x range of the edge.
+    */
+    bool touchesEdge(const Circle& local, vec2 end) {
+        if (local.centre.x < 0 || local.centre.x > end.x) {return false;}
+        return local.centre.y >= 0.0f && local.centre.y < local.radius;
+    }
 
-        else if (bc2 == longest) {
-            vec2 tmp = t.a;
-            t.a = t.b;
-            t.b = t.c;
-            t.c = tmp;
-        }
+    bool touchesEdge(Circle c, vec2 start, vec2 end) {
+        localiseEdge(c, start, end);
+        return touchesEdge(c, end);
+    }
 
-        // If ab is vertical, make ab horizontal.
-        ab = t.b - t.a;
-        if (ab.x == 0) {
-            t.rotate(90.0f, vec2(0.0f, 0.0f));
-            rotation += 90.0f;
+    /*
+    Gets the signed distance of p past the edge of the triangle it lies furthest outside of, along
+    with the index of that edge. The distance is negative when p is inside the triangle, and then
+    the edge is the one nearest to p.
+    */
+    float getEdgeDistance(vec2 p, const TriangleCache& t, int& edge) {
+        edge = 0;
+        float distance = glm::dot(p - t.vertices[0], t.normals[0]);
+        for (int i = 1; i < 3; i++) {
+            float d = glm::dot(p - t.vertices[i], t.normals[i]);
+            if (d > distance) {distance = d; edge = i;}
         }
+        return distance;
+    }
 
-        // Rotate the space such that ab is horizontal
-        ab = t.b - t.a;
-        float angle = ((atan(ab.y / ab.x)) * 180) / M_PI;
-        t.rotate(-angle, vec2(0.0f, 0.0f));
-        rotation -= angle;
+    CollisionResult getCollision(Circle c, vec2 p) {
 
-        // Ensure that c is above the line ab
-        if (t.c.y - t.a.y < 0) {
-            t.rotate(180.0f, vec2(0.0f, 0.0f));
-            rotation += 180.0f;
-        }
+        if (touchesCorner(c, p)) {
 
-        // Swap a and b if b.x comes before a.x
-        if (t.b.x < t.a.x) {
-            vec2 a = t.a;
-            vec2 b = t.b;
-            t.a = b;
-            t.b = a;
-        }
-
-        // Translate the space such that a is at the origin.
-        translation = -t.a;
-        t.translate(translation);
+            vec2 difference = c.centre - p;
+            vec2 normal = glm::normalize(difference);
+            vec2 depthVector = ((normal * c.radius) - difference) * 0.5f;
+            float depth = glm::length(depthVector);
+            vec2 point = p - depthVector;
 
-        // Return the triangle.
-        TriangleLocalisation result = {t, rotation, translation};
-        return result;
+            return {true, normal, point, depth, 0};
+        }
 
+        return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};
     }
 
-    struct IntersectionResult {
-        bool intersects;
-        vec2 point;
-    };
-
-    IntersectionResult getIntersection(vec2 aStart, vec2 aEnd, vec2 bStart, vec2 bEnd) {
-
-        aEnd -= aStart;
-        bStart -= aStart;
-        bEnd -= aStart;
-
-        float angle = -(atan(aEnd.y / aEnd.x) * 180) / M_PI;
-        rotateVector(aEnd, angle, vec2(0.0f, 0.0f));
-
-        if (aEnd.x < 0) {
-            rotateVector(aEnd, 180.0f, vec2(0.0f, 0.0f));
-            angle += 180.0f;
-        }
+    CollisionResult getCollision(Circle c, vec2 start, vec2 end) {
 
-        rotateVector(bStart, angle, vec2(0.0f, 0.0f));
-        rotateVector(bEnd, angle, vec2(0.0f, 0.0f));
+        // Move the circle into the space of the edge.
+        Rotation rotation = localiseEdge(c, start, end);
+        if (!touchesEdge(c, end)) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
 
-        float m = (bEnd.y - bStart.y) / (bEnd.x - bStart.x);
-        float b = bStart.y - m * bStart.x;
-        float x = -b / m;
+        // The perpendicular distance is the value of p.y after rotation.
+        float d = c.centre.y;
 
-        if (x >= 0.0f && x <= aEnd.x) {
+        // Collision results.
+        vec2 normal = vec2(0.0f, 1.0f);
+        float depth = (c.radius - d) * 0.5f;
+        vec2 point = vec2(c.centre.x, -depth);
 
-            vec2 point = vec2(x, 0.0f);
-            rotateVector(point, -angle, vec2(0.0f, 0.0f));
-            point += aStart;
+        rotateVector(normal, rotation.inverse(), vec2(0.0f, 0.0f));
+        rotateVector(point, rotation.inverse(), vec2(0.0f, 0.0f));
+        point += start;
 
-            return {true, point};
-        }
+        return {true, normal, point, depth, 0};
+    }
 
-        return {false, vec2(0.0f, 0.0f)};
+    inline bool touches(const Circle& a, const Circle& b) {
+        float sumRadii = a.radius + b.radius;
+        vec2 distance = a.centre - b.centre;
+        return !(glm::dot(distance, distance) - (sumRadii * sumRadii) > 0);
     }
 
-    bool intersects(vec2 aStart, vec2 aEnd, vec2 bStart, vec2 bEnd) {
-        float dx0 = aEnd.x - aStart.x;
-        float dx1 = bEnd.x - bStart.x;
-        float dy0 = aEnd.y - aStart.y;
-        float dy1 = bEnd.y - bStart.y;
-        float p0 = dy1 * (bEnd.x - aStart.x) - dx1 *(bEnd.y - aStart.y);
-        float p1 = dy1 * (bEnd.x - aEnd.x)   - dx1 *(bEnd.y - aEnd.y);
-        float p2 = dy0 * (aEnd.x - bStart.x) - dx0 *(aEnd.y - bStart.y);
-        float p3 = dy0 * (aEnd.x - bEnd.x)   - dx0 *(aEnd.y - bEnd.y);
-        return (p0 * p1 <= 0) && (p2 * p3 <= 0);
+    inline bool touches(const TriangleCache& a, const TriangleCache& b) {
+        return boundsOverlap(a, b) && !separates(a, b) && !separates(b, a);
     }
 
-    std::vector<Line> getIntersectingEdge(vec2 vertex, Triangle b, Triangle a) {
+    inline bool touches(const Circle& c, const TriangleCache& cache) {
 
-        std::vector<Line> result;
+        if (!boundsOverlap(c, cache)) {return false;}
+        const vec2* v = cache.vertices;
 
-        bool aFlag = false;
-        bool bFlag = false;
-        bool cFlag = false;
+        // A circle with its centre inside the triangle may reach none of its edges.
+        int edge;
+        if (getEdgeDistance(c.centre, cache, edge) < 0.0f) {return true;}
 
-        Line edge = b.left(vertex);
-        if (intersects(edge.start, edge.end, a.b, a.a)) {result.push_back(Line(a.b, a.a)); aFlag = true;}
-        if (intersects(edge.start, edge.end, a.a, a.c)) {result.push_back(Line(a.a, a.c)); bFlag = true;}
-        if (intersects(edge.start, edge.end, a.c, a.b)) {result.push_back(Line(a.c, a.b)); cFlag = true;}
+        // The corners need no square roots, so try them before the edges.
+        if (touchesCorner(c, v[0]) || touchesCorner(c, v[1]) || touchesCorner(c, v[2])) {return true;}
+        return touchesEdge(c, v[0], v[2]) || touchesEdge(c, v[2], v[1]) || touchesEdge(c, v[1], v[0]);
 
-        edge = b.right(vertex);
-        if (intersects(edge.start, edge.end, a.b, a.a) && !aFlag) {result.push_back(Line(a.b, a.a));}
-        if (intersects(edge.start, edge.end, a.a, a.c) && !bFlag) {result.push_back(Line(a.a, a.c));}
-        if (intersects(edge.start, edge.end, a.c, a.b) && !cFlag) {result.push_back(Line(a.c, a.b));}
+    }
 
-        return result;
+    inline CollisionResult collide(const Circle& a, const Circle& b) {
 
-    }
+        // Determine if the two circles are colliding.
+        if (!touches(a, b)) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
+        float sumRadii = a.radius + b.radius;
+        vec2 distance = a.centre - b.centre;
 
-    CollisionResult getCollision(Circle c, vec2 p) {
+        // Find the depth and normal of the collision
+        float depth = fabsf(glm::length(distance) - sumRadii) * 0.5f;
+        vec2 normal = glm::normalize(distance);
 
-        vec2 difference = c.centre - p;
-        if (glm::dot(difference, difference) < c.radius * c.radius) {
-            
-            vec2 normal = glm::normalize(difference);
-            vec2 depthVector = ((normal * c.radius) - difference) * 0.5f;
-            float depth = glm::length(depthVector);
-            vec2 point = p - depthVector;
+        // Find the contact point of the collision
+        float distanceToPoint = a.radius - depth;
+        vec2 point = distanceToPoint * -normal + a.centre;
 
-            return {true, normal, point, depth};
+        return {true, normal, point, depth, 0};
+    }
+
+    inline CollisionResult collide(const TriangleCache& aCache, const TriangleCache& bCache) {
+
+        // Do a bounding volume check to try see if a collision is possible
+        if (!boundsOverlap(aCache, bCache)) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
+
+        // Test the edge normals of both triangles as separating axes.
+        Penetration aPenetration = getPenetration(aCache, bCache);
+        if (aPenetration.separated) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
+        Penetration bPenetration = getPenetration(bCache, aCache);
+        if (bPenetration.separated) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
+
+        // The normal always points from B towards A.
+        // The contact point lies halfway between the deepest incident vertex and the reference edge.
+        if (bPenetration.overlap <= aPenetration.overlap) {
+            vec2 normal = bPenetration.normal;
+            float depth = bPenetration.overlap * 0.5f;
+            int vertex = getSupport(aCache, -normal);
+            vec2 point = aCache.vertices[vertex] + normal * depth;
+            unsigned int feature = getVertexFeature(aCache, vertex) | getEdgeFeature(bCache, bPenetration.edge) << 8;
+            return {true, normal, point, depth, feature};
         }
 
-        return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};
+        vec2 normal = -aPenetration.normal;
+        float depth = aPenetration.overlap * 0.5f;
+        int vertex = getSupport(bCache, normal);
+        vec2 point = bCache.vertices[vertex] - normal * depth;
+        unsigned int feature = getEdgeFeature(aCache, aPenetration.edge) | getVertexFeature(bCache, vertex) << 8;
+        return {true, normal, point, depth, feature};
+
     }
 
-    CollisionResult getCollision(Circle c, vec2 start, vec2 end) {
+    inline CollisionResult collide(const Circle& c, const TriangleCache& cache) {
 
-        // Keep track of any rotations and translations we make.
-        float rotation = 0.0f;
-        vec2 translation = vec2(0.0f, 0.0f);
+        // Do a bounding volume check to try see if a collision is possible
+        if (!boundsOverlap(c, cache)) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
 
-        // Translate the space to the origin.
-        c.centre -= start;
-        end -= start;
-        translation = -start;
-
-        // Rotate the space such that end is on the x axis.
-        float angle = ((atan(end.y / end.x)) * 180) / M_PI;
-        rotateVector(c.centre, -angle, vec2(0.0f, 0.0f));
-        rotateVector(end, -angle, vec2(0.0f, 0.0f));
-        rotation = -angle;
-
-        // If end.x is negative, let's rotate the plane by 180 degrees.
-        if (end.x < 0) {
-            rotateVector(c.centre, 180.0f, vec2(0.0f, 0.0f));
-            rotateVector(end, 180.0f, vec2(0.0f, 0.0f));
-            rotation += 180.0f;
+        // A centre inside the triangle is pushed back out through the nearest edge. The edge and
+        // corner tests below only see circles from outside, so this has to come first.
+        int edge;
+        float distance = getEdgeDistance(c.centre, cache, edge);
+        if (distance < 0.0f) {
+            vec2 normal = cache.normals[edge];
+            float depth = (c.radius - distance) * 0.5f;
+            vec2 point = c.centre - normal * (distance + depth);
+            return {true, normal, point, depth, getEdgeFeature(cache, edge) << 8};
         }
 
-        // The perpendicular distance is the absolute value of p.y after rotation.
-        float d = fabsf(c.centre.y);
-        if (d >= c.radius) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
-
-        // If the circle is not in the x range of the line, we do not consider it colliding.
-        if (c.centre.x < 0 || c.centre.x > end.x) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
-        if (c.centre.y < 0.0f || c.centre.y >= c.radius) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
+        // The cached vertices are counter-clockwise, so the edge tests work whatever the winding of t.
+        const vec2* v = cache.vertices;
+        CollisionResult result;
 
-        // Collision results.
-        vec2 normal = vec2(0.0f, 1.0f);
-        float depth = (c.radius - d) * 0.5f;
-        vec2 point = vec2(c.centre.x, -depth);
+        // Check if the circle collides with any edges. The triangle is shape B, so its feature goes in the second byte.
+        result = getCollision(c, v[0], v[2]); if (result.colliding) {result.feature = getEdgeFeature(cache, 2) << 8; return result;}
+        result = getCollision(c, v[2], v[1]); if (result.colliding) {result.feature = getEdgeFeature(cache, 1) << 8; return result;}
+        result = getCollision(c, v[1], v[0]); if (result.colliding) {result.feature = getEdgeFeature(cache, 0) << 8; return result;}
 
-        rotateVector(normal, -rotation ,vec2(0.0f, 0.0f));
-        rotateVector(point, -rotation ,vec2(0.0f, 0.0f));
-        point -= translation;
+        // Check if the circle collides with any corners.
+        result = getCollision(c, v[0]); if (result.colliding) {result.feature = getVertexFeature(cache, 0) << 8; return result;}
+        result = getCollision(c, v[1]); if (result.colliding) {result.feature = getVertexFeature(cache, 1) << 8; return result;}
+        result = getCollision(c, v[2]); if (result.colliding) {result.feature = getVertexFeature(cache, 2) << 8; return result;}
 
-        return {true, normal, point, depth};
+        return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};
     }
 
-}
-
-CollisionResult getCollision(Circle a, Circle b) {
+    // Shapes without a cache get one on the stack, once their bounding boxes overlap.
+    inline bool touches(const Triangle& a, const Triangle& b) {
+        if (!boundsOverlap(a.getAABB(), b.getAABB())) {return false;}
+        return touches(TriangleCache(a), TriangleCache(b));
+    }
 
-    // Determine if the two circles are colliding.
-    float sumRadii = a.radius + b.radius;
-    vec2 distance = a.centre - b.centre;
-    if (glm::dot(distance, distance) - (sumRadii * sumRadii) > 0) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
+    inline bool touches(const Circle& c, const Triangle& t) {
+        if (!boundsOverlap(c, t.getAABB())) {return false;}
+        return touches(c, TriangleCache(t));
+    }
 
-    // Find the depth and normal of the collision
-    float depth = fabsf(glm::length(distance) - sumRadii) * 0.5f;
-    vec2 normal = glm::normalize(distance);
+    inline CollisionResult collide(const Triangle& a, const Triangle& b) {
+        if (!boundsOverlap(a.getAABB(), b.getAABB())) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
+        return collide(TriangleCache(a), TriangleCache(b));
+    }
 
-    // Find the contact point of the collision
-    float distanceToPoint = a.radius - depth;
-    vec2 point = distanceToPoint * -normal + a.centre;
+    inline CollisionResult collide(const Circle& c, const Triangle& t) {
+        if (!boundsOverlap(c, t.getAABB())) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};}
+        return collide(c, TriangleCache(t));
+    }
 
-    return {true, normal, point, depth};
-}
+    template <typename A, typename B>
+    int collideAll(const A* a, const B* b, int n, CollisionResult* results, int* indices) {
+
+        // Results are written unconditionally and the count only advances on a hit.
+        // This keeps the compaction free of unpredictable branches.
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            CollisionResult result = collide(a[i], b[i]);
+            results[count] = result;
+            indices[count] = i;
+            count += result.colliding ? 1 : 0;
+        }
 
-CollisionResult getCollision(Triangle a, Triangle b) {
+        return count;
 
-    // Do a bounding box check to try see if a collision is possible
-    bool colliding = false;
-    vec2 aMin = vec2(std::min(std::min(a.a.x, a.b.x), a.c.x), std::min(std::min(a.a.y, a.b.y), a.c.y));
-    vec2 aMax = vec2(std::max(std::max(a.a.x, a.b.x), a.c.x), std::max(std::max(a.a.y, a.b.y), a.c.y));
-    vec2 bMin = vec2(std::min(std::min(b.a.x, b.b.x), b.c.x), std::min(std::min(b.a.y, b.b.y), b.c.y));
-    vec2 bMax = vec2(std::max(std::max(b.a.x, b.b.x), b.c.x), std::max(std::max(b.a.y, b.b.y), b.c.y));
+    }
 
-    // Check if both triangle aabbs overlap.
-    colliding = aMin.x < bMax.x && aMax.x > bMin.x && aMin.y < bMax.y && aMax.y > bMin.y;
-    if (!colliding) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
+    // Kernels for the dispatch table, indexed by the shape types of both shapes.
+    CollisionResult collideCircleCircle(const void* a, const void* b) {
+        return collide(*(const Circle*) a, *(const Circle*) b);
+    }
 
-    // Triangles in A's local space.
-    TriangleLocalisation aLocalisation = localise(a);
-    Triangle laa = aLocalisation.triangle;
-    Triangle lab = Triangle(b.a, b.b, b.c);
-    lab.rotate(aLocalisation.rotation, vec2(0.0f, 0.0f));
-    lab.translate(aLocalisation.translation);
+    CollisionResult collideCircleTriangle(const void* a, const void* b) {
+        return collide(*(const Circle*) a, *(const Triangle*) b);
+    }
 
-    // Triangles in B's local space.
-    TriangleLocalisation bLocalisation = localise(b);
-    Triangle lbb = bLocalisation.triangle;
-    Triangle lba = Triangle(a.a, a.b, a.c);
-    lba.rotate(bLocalisation.rotation, vec2(0.0f, 0.0f));
-    lba.translate(bLocalisation.translation);
+    CollisionResult collideTriangleCircle(const void* a, const void* b) {
+        return flip(collide(*(const Circle*) b, *(const Triangle*) a));
+    }
 
-    // Find points in triangle B that collide with triangle A.
-    std::vector<vec2> aPoints;
-    if (intersects(lab.a, laa)) {aPoints.push_back(b.a);}
-    if (intersects(lab.b, laa)) {aPoints.push_back(b.b);}
-    if (intersects(lab.c, laa)) {aPoints.push_back(b.c);}
+    CollisionResult collideTriangleTriangle(const void* a, const void* b) {
+        return collide(*(const Triangle*) a, *(const Triangle*) b);
+    }
 
-    if (aPoints.size() == 3) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
+    bool touchesCircleCircle(const void* a, const void* b) {
+        return touches(*(const Circle*) a, *(const Circle*) b);
+    }
 
-    // Find points in triangle A that collide with triangle B.
-    std::vector<vec2> bPoints;
-    if (intersects(lba.a, lbb)) {bPoints.push_back(a.a);}
-    if (intersects(lba.b, lbb)) {bPoints.push_back(a.b);}
-    if (intersects(lba.c, lbb)) {bPoints.push_back(a.c);}
+    bool touchesCircleTriangle(const void* a, const void* b) {
+        return touches(*(const Circle*) a, *(const Triangle*) b);
+    }
 
-    if (bPoints.size() == 3) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
-    if (aPoints.size() == 0 && bPoints.size() == 0) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
+    bool touchesTriangleCircle(const void* a, const void* b) {
+        return touches(*(const Circle*) b, *(const Triangle*) a);
+    }
 
-    // If the more points in b were found than a, swap the problem
-    float flip = -1.0f;
-    if (aPoints.size() < bPoints.size()) {
+    bool touchesTriangleTriangle(const void* a, const void* b) {
+        return touches(*(const Triangle*) a, *(const Triangle*) b);
+    }
 
-        // Swap the triangles
-        Triangle t = a;
-        a = b;
-        b = t;
+    typedef CollisionResult (*CollisionKernel)(const void* a, const void* b);
+    typedef bool (*OverlapKernel)(const void* a, const void* b);
 
-        // Swap the vectors
-        std::vector<vec2> points;
-        aPoints = bPoints;
-        bPoints = points;
+    const CollisionKernel COLLISION_KERNELS[2][2] = {
+        {collideCircleCircle, collideCircleTriangle},
+        {collideTriangleCircle, collideTriangleTriangle}
+    };
 
-        // Flip the float
-        flip = 1.0f;
+    const OverlapKernel OVERLAP_KERNELS[2][2] = {
+        {touchesCircleCircle, touchesCircleTriangle},
+        {touchesTriangleCircle, touchesTriangleTriangle}
+    };
 
-    }
+}
 
-    if (aPoints.size() == 1 && bPoints.size() == 0) {
+CollisionResult getCollision(Circle a, Circle b) {
+    return collide(a, b);
+}
 
-        // Find the vertex and centroid.
-        vec2 vertex = aPoints[0];
-        vec2 centroid = b.centroid();
+CollisionResult getCollision(const Triangle& a, const Triangle& b) {
+    return collide(a, b);
+}
 
-        std::vector<Line> edges = getIntersectingEdge(vertex, b, a);
-        if (edges.size() == 1) {
+CollisionResult getCollision(Circle c, const Triangle& t) {
+    return collide(c, t);
+}
 
-            Line edge = edges[0];
-            vec2 normal = flip * getNormal(edge.start, edge.end);
-            float depth = getDistance(vertex, centroid, edge.start, edge.end) * 0.5f;
-            vec2 point = vertex + glm::normalize(centroid - vertex) * depth;
-        
-            return {true, normal, point, depth};
-        }
+CollisionResult getCollision(const Triangle& t, Circle c) {
+    return flip(collide(c, t));
+}
 
-        else {
-            // TODO: ADD COLLISION FOR THIS CASE.
+CollisionResult getCollision(const TriangleCache& a, const TriangleCache& b) {
+    return collide(a, b);
+}
 
-            // POSSIBLE SOLUTIONS:
-            // IF THE EDGE DISTANCE IS GREATER THAN MINIMUM CENTROID TO VERTEX DISTANCE OF THE OTHER TRIANGLE COLLIDE ON THAT EDGE
-            // IF THE EDGE OPPOSING THE VERTEX INTERSECTS BOTH EDGES IN THE OTHER TRIANGLE, COLLIDE WITH SOMETHING
+CollisionResult getCollision(Circle c, const TriangleCache& t) {
+    return collide(c, t);
+}
 
-            return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};
-        }
+CollisionResult getCollision(const TriangleCache& t, Circle c) {
+    return flip(collide(c, t));
+}
 
-    }
+CollisionResult getCollision(const ShapeRef& a, const ShapeRef& b) {
+    return COLLISION_KERNELS[(int) a.type][(int) b.type](a.shape, b.shape);
+}
 
-    if (aPoints.size() == 1 && bPoints.size() == 1) {
+bool overlaps(Circle a, Circle b) {
+    return touches(a, b);
+}
 
-        // Find the closest edge in triangle A to the point of B that intersects A.
-        float bestDistance = std::numeric_limits<float>::max();
-        float distance = 0.0f;
-        Line bestEdge = Line(vec2(0.0f, 0.0f), vec2(0.0f, 0.0f));
-        Triangle bestTriangle = b;
-        
-        // Find the closest edge in A to the point of collision.
-        std::vector<Line> aEdges = getIntersectingEdge(aPoints[0], b, a);
-        distance = getDistance(aPoints[0], a.left(aPoints[0]).end, aEdges[0].start, aEdges[0].end);
-        if (distance < bestDistance) {
-            bestDistance = distance;
-            bestEdge = aEdges[0];
-            bestTriangle = b;
-            flip = 1.0f;
-        }
+bool overlaps(const Triangle& a, const Triangle& b) {
+    return touches(a, b);
+}
 
-        distance = getDistance(aPoints[0], a.right(aPoints[0]).end, aEdges[1].start, aEdges[1].end);
-        if (distance < bestDistance) {
-            bestDistance = distance;
-            bestEdge = aEdges[1];
-            bestTriangle = a;
-            flip = 1.0f;
-        }
-        
-        // See if any edge in B is closer.
-        std::vector<Line> bEdges = getIntersectingEdge(bPoints[0], a, b);
-        distance = getDistance(bPoints[0], b.left(bPoints[0]).end, bEdges[0].start, bEdges[0].end);
-        if (distance < bestDistance) {
-            bestDistance = distance;
-            bestEdge = bEdges[0];
-            bestTriangle = a;
-            flip = -1.0f;
-        }
-        
-        distance = getDistance(bPoints[0], b.right(bPoints[0]).end, bEdges[1].start, bEdges[1].end);
-        if (distance < bestDistance) {
-            bestDistance = distance;
-            bestEdge = bEdges[1];
-            bestTriangle = a;
-            flip = -1.0f;
-        }
+bool overlaps(Circle c, const Triangle& t) {
+    return touches(c, t);
+}
 
-        // The point of collision is the average of both vertices that collided.
-        vec2 vertex = (aPoints[0] + bPoints[0]) * 0.5f;
-        vec2 normal = flip * getNormal(bestEdge.end, bestEdge.start);
-        vec2 centroid = bestTriangle.centroid();
-        float depth = getDistance(vertex, centroid, bestEdge.start, bestEdge.end) * 0.5f;
+bool overlaps(const Triangle& t, Circle c) {
+    return touches(c, t);
+}
 
-        return {true, normal, vertex, depth};
-    }
+bool overlaps(const TriangleCache& a, const TriangleCache& b) {
+    return touches(a, b);
+}
 
-    if (aPoints.size() == 2) {
+bool overlaps(Circle c, const TriangleCache& t) {
+    return touches(c, t);
+}
 
-        vec2 vertex = 0.5f * (aPoints[0] + aPoints[1]);
-        Line edge = getIntersectingEdge(aPoints[0], b, a)[0];
-        vec2 centroid = b.centroid();
+bool overlaps(const TriangleCache& t, Circle c) {
+    return touches(c, t);
+}
 
-        vec2 normal = flip * getNormal(aPoints[0], aPoints[1]);
-        float depth = getDistance(vertex, centroid, edge.start, edge.end) * 0.5f;
-        vec2 point = vertex + glm::normalize(centroid - vertex) * depth;
+bool overlaps(const ShapeRef& a, const ShapeRef& b) {
+    return OVERLAP_KERNELS[(int) a.type][(int) b.type](a.shape, b.shape);
+}
 
-        return {true, normal, point, depth};
-    }
+bool overlaps(AABB a, AABB b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
 
-    return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};
+int getCollisions(const Circle* a, const Circle* b, int n, CollisionResult* results, int* indices) {
+    return collideAll(a, b, n, results, indices);
 }
 
-CollisionResult getCollision(Circle c, Triangle t) {
-
-    // Do a bounding box check to try see if a collision is possible
-    bool colliding = false;
-    vec2 min = vec2(std::min(std::min(t.a.x, t.b.x), t.c.x) - c.radius, std::min(std::min(t.a.y, t.b.y), t.c.y) - c.radius);
-    vec2 max = vec2(std::max(std::max(t.a.x, t.b.x), t.c.x) + c.radius, std::max(std::max(t.a.y, t.b.y), t.c.y) + c.radius);
-
-    // Check if the circle is in the triangles aabb
-    colliding = c.centre.x >= min.x && c.centre.x <= max.x && c.centre.y >= min.y && c.centre.y <= max.y;
-    if (!colliding) {return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};}
-    
-    CollisionResult result; 
-
-    // Check if the circle collides with any edges.
-    result = getCollision(c, t.a, t.c); if (result.colliding) {return result;}
-    result = getCollision(c, t.c, t.b); if (result.colliding) {return result;}
-    result = getCollision(c, t.b, t.a); if (result.colliding) {return result;}
-    
-    // Check if the circle collides with any corners.
-    result = getCollision(c, t.a); if (result.colliding) {return result;}
-    result = getCollision(c, t.b); if (result.colliding) {return result;}
-    result = getCollision(c, t.c); if (result.colliding) {return result;}
-    
-    return {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f};
+int getCollisions(const Triangle* a, const Triangle* b, int n, CollisionResult* results, int* indices) {
+    return collideAll(a, b, n, results, indices);
 }
 
-CollisionResult getCollision(Triangle t, Circle c) {
-    CollisionResult result = getCollision(c, t);
-    result.normal = -result.normal;
-    return result;
+int getCollisions(const Circle* c, const Triangle* t, int n, CollisionResult* results, int* indices) {
+    return collideAll(c, t, n, results, indices);
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <cmath>
+#include <algorithm>
+#include "grid.hpp"
+
+Grid::Grid(float cellSize, vec2 min, vec2 max) {
+    this->cellSize = cellSize;
+    this->origin = min;
+    this->width = std::max((int) ceilf((max.x - min.x) / cellSize), 1);
+    this->height = std::max((int) ceilf((max.y - min.y) / cellSize), 1);
+    this->buckets = this->width * this->height;
+    this->hashed = false;
+    this->built = false;
+}
+
+Grid::Grid(float cellSize, int buckets) {
+    this->cellSize = cellSize;
+    this->origin = vec2(0.0f, 0.0f);
+    this->width = 0;
+    this->height = 0;
+    this->buckets = buckets;
+    this->hashed = true;
+    this->built = false;
+}
+
+void Grid::insert(int id, AABB aabb) {
+    this->proxies.insert(id, aabb);
+    this->built = false;
+}
+
+void Grid::update(int id, AABB aabb) {
+    this->proxies.update(id, aabb);
+    this->built = false;
+}
+
+void Grid::remove(int id) {
+    this->proxies.remove(id);
+    this->built = false;
+}
+
+int Grid::getCell(float value, int axis) const {
+
+    int cell = (int) floorf((value - this->origin[axis]) / this->cellSize);
+    if (this->hashed) {return cell;}
+
+    // Bounded grids clamp anything outside of the grid into the border cells.
+    int size = axis == 0 ? this->width : this->height;
+    return std::min(std::max(cell, 0), size - 1);
+
+}
+
+int Grid::getBucket(int x, int y) const {
+    if (!this->hashed) {return x + y * this->width;}
+    unsigned int hash = ((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u);
+    return hash % (unsigned int) this->buckets;
+}
+
+void Grid::build() {
+
+    if (this->built) {return;}
+
+    // Count the entries in each bucket.
+    this->starts.assign(this->buckets + 1, 0);
+    for (int id : this->proxies.ids) {
+        AABB aabb = this->proxies.getAABB(id);
+        int x0 = this->getCell(aabb.min.x, 0), x1 = this->getCell(aabb.max.x, 0);
+        int y0 = this->getCell(aabb.min.y, 1), y1 = this->getCell(aabb.max.y, 1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                this->starts[this->getBucket(x, y) + 1]++;
+            }
+        }
+    }
+
+    // Turn the counts into the first entry of each bucket.
+    for (int i = 0; i < this->buckets; i++) {
+        this->starts[i + 1] += this->starts[i];
+    }
+
+    // Scatter the entries into their buckets.
+    this->entries.resize(this->starts[this->buckets]);
+    this->cursors.assign(this->starts.begin(), this->starts.end() - 1);
+    for (int id : this->proxies.ids) {
+        AABB aabb = this->proxies.getAABB(id);
+        int x0 = this->getCell(aabb.min.x, 0), x1 = this->getCell(aabb.max.x, 0);
+        int y0 = this->getCell(aabb.min.y, 1), y1 = this->getCell(aabb.max.y, 1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                this->entries[this->cursors[this->getBucket(x, y)]++] = {id, x, y};
+            }
+        }
+    }
+
+    this->built = true;
+
+}
+
+void Grid::query(AABB region, std::vector<int>& result) {
+
+    this->build();
+
+    int x0 = this->getCell(region.min.x, 0), x1 = this->getCell(region.max.x, 0);
+    int y0 = this->getCell(region.min.y, 1), y1 = this->getCell(region.max.y, 1);
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+
+            int bucket = this->getBucket(x, y);
+            for (int i = this->starts[bucket]; i < this->starts[bucket + 1]; i++) {
+
+                Entry entry = this->entries[i];
+                if (entry.x != x || entry.y != y) {continue;}
+
+                AABB aabb = this->proxies.getAABB(entry.id);
+                if (!overlaps(aabb, region)) {continue;}
+
+                // Only report the proxy from the cell holding the minimum corner of the overlap.
+                if (this->getCell(std::max(aabb.min.x, region.min.x), 0) != x) {continue;}
+                if (this->getCell(std::max(aabb.min.y, region.min.y), 1) != y) {continue;}
+                result.push_back(entry.id);
+
+            }
+
+        }
+    }
+
+}
+
+void Grid::getPairs(std::vector<Pair>& pairs) {
+
+    this->build();
+    pairs.clear();
+
+    for (int bucket = 0; bucket < this->buckets; bucket++) {
+
+        int start = this->starts[bucket];
+        int end = this->starts[bucket + 1];
+
+        for (int i = start; i < end; i++) {
+
+            Entry a = this->entries[i];
+            AABB aabb = this->proxies.getAABB(a.id);
+
+            for (int j = i + 1; j < end; j++) {
+
+                // Hashed buckets can hold entries from different cells.
+                Entry b = this->entries[j];
+                if (a.x != b.x || a.y != b.y) {continue;}
+
+                AABB other = this->proxies.getAABB(b.id);
+                if (!overlaps(aabb, other)) {continue;}
+
+                // Only report the pair from the cell holding the minimum corner of the overlap.
+                if (this->getCell(std::max(aabb.min.x, other.min.x), 0) != a.x) {continue;}
+                if (this->getCell(std::max(aabb.min.y, other.min.y), 1) != a.y) {continue;}
+                pairs.push_back({std::min(a.id, b.id), std::max(a.id, b.id)});
+
+            }
+
+        }
+
+    }
+
+}
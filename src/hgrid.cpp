@@ -0,0 +1,156 @@
+#include <cmath>
+#include <algorithm>
+#include "hgrid.hpp"
+
+HierarchicalGrid::HierarchicalGrid(float cellSize, int levels, int buckets) {
+    this->cellSize = cellSize;
+    this->levels = std::max(levels, 1);
+    this->buckets = buckets;
+    this->built = false;
+    for (int level = 0; level < this->levels; level++) {
+        this->inverses.push_back(1.0f / ldexpf(cellSize, level));
+    }
+}
+
+void HierarchicalGrid::insert(int id, AABB aabb) {
+    this->proxies.insert(id, aabb);
+    this->built = false;
+}
+
+void HierarchicalGrid::update(int id, AABB aabb) {
+    this->proxies.update(id, aabb);
+    this->built = false;
+}
+
+void HierarchicalGrid::remove(int id) {
+    this->proxies.remove(id);
+    this->built = false;
+}
+
+int HierarchicalGrid::getLevel(AABB aabb) const {
+
+    vec2 extent = aabb.max - aabb.min;
+    float largest = std::max(extent.x, extent.y);
+
+    int level = 0;
+    float size = this->cellSize;
+    while (size < largest && level < this->levels - 1) {
+        size *= 2.0f;
+        level++;
+    }
+
+    return level;
+
+}
+
+int HierarchicalGrid::getCell(float value, int level) const {
+    return (int) floorf(value * this->inverses[level]);
+}
+
+int HierarchicalGrid::getBucket(int x, int y, int level) const {
+    unsigned int hash = ((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u) ^ ((unsigned int) level * 83492791u);
+    return hash % (unsigned int) this->buckets;
+}
+
+void HierarchicalGrid::build() {
+
+    if (this->built) {return;}
+
+    this->counts.assign(this->levels, 0);
+    this->extents.assign(this->levels, 0.0f);
+    this->starts.assign(this->buckets + 1, 0);
+
+    // Count the entries in each bucket, and find the largest AABB on each level.
+    for (int id : this->proxies.ids) {
+        AABB aabb = this->proxies.getAABB(id);
+        vec2 extent = aabb.max - aabb.min;
+        int level = this->getLevel(aabb);
+        this->counts[level]++;
+        this->extents[level] = std::max(this->extents[level], std::max(extent.x, extent.y));
+        this->starts[this->getBucket(this->getCell(aabb.min.x, level), this->getCell(aabb.min.y, level), level) + 1]++;
+    }
+
+    // Turn the counts into the first entry of each bucket.
+    for (int i = 0; i < this->buckets; i++) {
+        this->starts[i + 1] += this->starts[i];
+    }
+
+    // Scatter the entries into their buckets.
+    this->entries.resize(this->starts[this->buckets]);
+    this->cursors.assign(this->starts.begin(), this->starts.end() - 1);
+    for (int id : this->proxies.ids) {
+        AABB aabb = this->proxies.getAABB(id);
+        int level = this->getLevel(aabb);
+        int x = this->getCell(aabb.min.x, level);
+        int y = this->getCell(aabb.min.y, level);
+        this->entries[this->cursors[this->getBucket(x, y, level)]++] = {id, x, y, level};
+    }
+
+    this->built = true;
+
+}
+
+void HierarchicalGrid::search(AABB region, int level, std::vector<int>& result) const {
+
+    // Anything overlapping the region has its minimum corner within the largest extent of the level below it.
+    float extent = this->extents[level];
+    int x0 = this->getCell(region.min.x - extent, level), x1 = this->getCell(region.max.x, level);
+    int y0 = this->getCell(region.min.y - extent, level), y1 = this->getCell(region.max.y, level);
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+
+            int bucket = this->getBucket(x, y, level);
+            for (int i = this->starts[bucket]; i < this->starts[bucket + 1]; i++) {
+
+                // Buckets can hold entries from different cells and levels.
+                Entry entry = this->entries[i];
+                if (entry.x != x || entry.y != y || entry.level != level) {continue;}
+                if (overlaps(this->proxies.getAABB(entry.id), region)) {result.push_back(entry.id);}
+
+            }
+
+        }
+    }
+
+}
+
+void HierarchicalGrid::query(AABB region, std::vector<int>& result) {
+
+    this->build();
+
+    for (int level = 0; level < this->levels; level++) {
+        if (this->counts[level] == 0) {continue;}
+        this->search(region, level, result);
+    }
+
+}
+
+void HierarchicalGrid::getPairs(std::vector<Pair>& pairs) {
+
+    this->build();
+    pairs.clear();
+
+    // Each proxy searches its own level and the levels above it. The larger proxies never look
+    // down, and pairs on the same level are kept by the proxy with the lower id.
+    for (const Entry& entry : this->entries) {
+
+        AABB aabb = this->proxies.getAABB(entry.id);
+
+        for (int level = entry.level; level < this->levels; level++) {
+
+            if (this->counts[level] == 0) {continue;}
+
+            this->found.clear();
+            this->search(aabb, level, this->found);
+
+            for (int other : this->found) {
+                if (level == entry.level && other <= entry.id) {continue;}
+                pairs.push_back({std::min(entry.id, other), std::max(entry.id, other)});
+            }
+
+        }
+
+    }
+
+}
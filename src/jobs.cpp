@@ -0,0 +1,173 @@
+#include <algorithm>
+#include "jobs.hpp"
+
+namespace {
+
+    // The system the current thread works for, and its index there. Other threads run as thread 0.
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local int currentThread = 0;
+
+}
+
+JobSystem::JobSystem(int threads) {
+
+    threads = std::max(threads, 1);
+    this->queued = 0;
+    this->sleeping = 0;
+    this->stopping = false;
+
+    for (int t = 0; t < threads; t++) {this->queues.emplace_back(new Queue());}
+    for (int t = 1; t < threads; t++) {this->workers.emplace_back(&JobSystem::loop, this, t);}
+
+}
+
+JobSystem::~JobSystem() {
+
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping = true;
+    }
+
+    this->wake.notify_all();
+    for (std::thread& worker : this->workers) {worker.join();}
+
+}
+
+int JobSystem::getThreadCount() const {
+    return this->queues.size();
+}
+
+int JobSystem::getThread() const {
+    return currentSystem == this ? currentThread : 0;
+}
+
+void JobSystem::run(int n, int grain, Body body, const void* context) {
+
+    if (n <= 0) {return;}
+    grain = std::max(grain, 1);
+    int chunks = (n + grain - 1) / grain;
+
+    // Nothing to share, so run the chunks in order.
+    if (this->workers.empty() || chunks == 1) {
+        for (int begin = 0; begin < n; begin += grain) {body(context, begin, std::min(begin + grain, n));}
+        return;
+    }
+
+    int thread = this->getThread();
+
+    Job job;
+    job.body = body;
+    job.context = context;
+    job.n = n;
+    job.grain = grain;
+    job.pending = chunks;
+
+    // Help with any task until every chunk of this job has run, and sleep while there is none.
+    this->execute(thread, {&job, 0, chunks});
+    while (job.pending.load() > 0) {
+        if (this->runOne(thread)) {continue;}
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->sleeping++;
+        this->wake.wait(lock, [this, &job] {return job.pending.load() == 0 || this->queued.load() > 0;});
+        this->sleeping--;
+    }
+
+}
+
+void JobSystem::push(int thread, Task task) {
+
+    {
+        std::lock_guard<std::mutex> lock(this->queues[thread]->mutex);
+        this->queues[thread]->tasks.push_back(task);
+    }
+
+    // A thread about to sleep checks queued under the sleep mutex, so taking it here means
+    // the notification cannot arrive between its check and its wait.
+    this->queued++;
+    if (this->sleeping.load() > 0) {
+        { std::lock_guard<std::mutex> lock(this->sleepMutex); }
+        this->wake.notify_one();
+    }
+
+}
+
+bool JobSystem::pop(int thread, Task& task) {
+
+    Queue& queue = *this->queues[thread];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {return false;}
+
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    this->queued--;
+    return true;
+
+}
+
+bool JobSystem::steal(int thread, Task& task) {
+
+    int count = this->queues.size();
+    for (int offset = 1; offset < count; offset++) {
+
+        Queue& queue = *this->queues[(thread + offset) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {continue;}
+
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        this->queued--;
+        return true;
+
+    }
+
+    return false;
+
+}
+
+bool JobSystem::runOne(int thread) {
+    Task task;
+    if (!this->pop(thread, task) && !this->steal(thread, task)) {return false;}
+    this->execute(thread, task);
+    return true;
+}
+
+void JobSystem::execute(int thread, Task task) {
+
+    // Leave the second half of the range for others to steal, until one chunk is left.
+    while (task.last - task.first > 1) {
+        int middle = task.first + (task.last - task.first) / 2;
+        this->push(thread, {task.job, middle, task.last});
+        task.last = middle;
+    }
+
+    Job* job = task.job;
+    int begin = task.first * job->grain;
+    job->body(job->context, begin, std::min(begin + job->grain, job->n));
+
+    // The last chunk wakes the thread waiting on the job, which may be asleep. The job belongs to
+    // that thread and may be gone as soon as pending reaches zero, so it is not touched after.
+    if (job->pending.fetch_sub(1) == 1 && this->sleeping.load() > 0) {
+        { std::lock_guard<std::mutex> lock(this->sleepMutex); }
+        this->wake.notify_all();
+    }
+
+}
+
+void JobSystem::loop(int thread) {
+
+    currentSystem = this;
+    currentThread = thread;
+
+    while (true) {
+
+        if (this->runOne(thread)) {continue;}
+
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->sleeping++;
+        this->wake.wait(lock, [this] {return this->queued.load() > 0 || this->stopping;});
+        this->sleeping--;
+        if (this->stopping) {return;}
+
+    }
+
+}
@@ -0,0 +1,318 @@
+#include <cmath>
+#include <algorithm>
+#include "lbvh.hpp"
+
+namespace {
+
+    const int NONE = -1;
+    const int RADIX = 256;
+    const int STACK_SIZE = 128;
+
+    // Stages are split into about this many chunks per thread, and no chunk is smaller than MIN_GRAIN.
+    const int CHUNKS_PER_THREAD = 4;
+    const int MIN_GRAIN = 1024;
+
+    AABB combine(AABB a, AABB b) {
+        return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+    }
+
+    // Spreads the low 16 bits of v out to the even bits.
+    uint32_t spread(uint32_t v) {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    // Counts the leading zero bits of v, which must not be zero.
+    int countLeadingZeros(uint64_t v) {
+        int count = 0;
+        for (int shift = 32; shift > 0; shift /= 2) {
+            if ((v >> (64 - shift - count)) == 0) {count += shift;}
+        }
+        return count;
+    }
+
+}
+
+LinearBVH::LinearBVH() : LinearBVH(nullptr) {}
+
+LinearBVH::LinearBVH(JobSystem* jobs) {
+    this->jobs = jobs;
+    this->built = false;
+    this->count = 0;
+    this->capacity = 0;
+}
+
+void LinearBVH::insert(int id, AABB aabb) {
+    this->proxies.insert(id, aabb);
+    this->built = false;
+}
+
+void LinearBVH::update(int id, AABB aabb) {
+    this->proxies.update(id, aabb);
+    this->built = false;
+}
+
+void LinearBVH::remove(int id) {
+    this->proxies.remove(id);
+    this->built = false;
+}
+
+int LinearBVH::getGrain(int n) const {
+    int threads = this->jobs == nullptr ? 1 : this->jobs->getThreadCount();
+    int chunks = threads * CHUNKS_PER_THREAD;
+    return std::max((n + chunks - 1) / chunks, MIN_GRAIN);
+}
+
+void LinearBVH::build() {
+
+    if (this->built) {return;}
+    this->built = true;
+
+    int n = this->proxies.ids.size();
+    this->count = n;
+    if (n == 0) {
+        this->nodes.clear();
+        return;
+    }
+
+    this->aabbs.resize(n);
+    this->centres.resize(n);
+    this->keys.resize(n);
+    this->swap.resize(n);
+    this->nodes.resize(2 * n - 1);
+    this->parents.resize(2 * n - 1);
+
+    if (this->capacity < n) {
+        this->arrivals.reset(new std::atomic<int>[n]);
+        this->capacity = n;
+    }
+
+    int grain = this->getGrain(n);
+
+    // Find the AABB and centre of every proxy, and the bounds of the centres in each chunk.
+    std::vector<AABB> bounds((n + grain - 1) / grain);
+    this->parallelFor(n, grain, [this, grain, &bounds](int begin, int end) {
+        AABB local = {vec2(INFINITY), vec2(-INFINITY)};
+        for (int i = begin; i < end; i++) {
+            this->aabbs[i] = this->proxies.getAABB(this->proxies.ids[i]);
+            this->centres[i] = (this->aabbs[i].min + this->aabbs[i].max) * 0.5f;
+            local = combine(local, {this->centres[i], this->centres[i]});
+        }
+        bounds[begin / grain] = local;
+    });
+
+    AABB total = bounds[0];
+    for (int k = 1; k < (int) bounds.size(); k++) {total = combine(total, bounds[k]);}
+    vec2 scale = 65535.0f / glm::max(total.max - total.min, vec2(1e-20f));
+
+    // Quantise the centres to 16 bits per axis and interleave them. The proxy index in the
+    // low half of each key keeps the keys unique, which the linking step relies on.
+    this->parallelFor(n, grain, [this, total, scale](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            vec2 cell = (this->centres[i] - total.min) * scale;
+            uint32_t code = spread((uint32_t) cell.x) | (spread((uint32_t) cell.y) << 1);
+            this->keys[i] = ((uint64_t) code << 32) | (uint32_t) i;
+            this->arrivals[i].store(0, std::memory_order_relaxed);
+        }
+    });
+
+    this->sort();
+
+    // Every internal node can be found on its own from the sorted keys.
+    this->parallelFor(n - 1, grain, [this](int begin, int end) {
+        for (int i = begin; i < end; i++) {this->link(i);}
+    });
+
+    // Place the leaves, then fill in the AABBs from the bottom up.
+    this->parents[0] = NONE;
+    this->parallelFor(n, grain, [this, n](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int proxy = (int) (uint32_t) this->keys[i];
+            this->nodes[n - 1 + i] = {this->aabbs[proxy], NONE, this->proxies.ids[proxy]};
+        }
+    });
+
+    this->parallelFor(n, grain, [this, n](int begin, int end) {
+        for (int i = begin; i < end; i++) {this->refit(n - 1 + i);}
+    });
+
+}
+
+void LinearBVH::sort() {
+
+    int n = this->count;
+    int grain = this->getGrain(n);
+    int chunks = (n + grain - 1) / grain;
+    std::vector<int> histograms(chunks * RADIX);
+
+    // Least significant digit first radix sort of the Morton codes, eight bits at a time.
+    // Each chunk is counted on its own, then scattered to offsets after every earlier chunk.
+    for (int shift = 32; shift < 64; shift += 8) {
+
+        std::fill(histograms.begin(), histograms.end(), 0);
+
+        this->parallelFor(n, grain, [this, shift, grain, &histograms](int begin, int end) {
+            int* histogram = &histograms[begin / grain * RADIX];
+            for (int i = begin; i < end; i++) {histogram[(this->keys[i] >> shift) & (RADIX - 1)]++;}
+        });
+
+        int offset = 0;
+        for (int digit = 0; digit < RADIX; digit++) {
+            for (int k = 0; k < chunks; k++) {
+                int size = histograms[k * RADIX + digit];
+                histograms[k * RADIX + digit] = offset;
+                offset += size;
+            }
+        }
+
+        this->parallelFor(n, grain, [this, shift, grain, &histograms](int begin, int end) {
+            int* cursor = &histograms[begin / grain * RADIX];
+            for (int i = begin; i < end; i++) {this->swap[cursor[(this->keys[i] >> shift) & (RADIX - 1)]++] = this->keys[i];}
+        });
+
+        this->keys.swap(this->swap);
+
+    }
+
+}
+
+void LinearBVH::link(int i) {
+
+    int n = this->count;
+    const std::vector<uint64_t>& keys = this->keys;
+
+    // The length of the common prefix of two keys, or -1 outside of the array.
+    auto prefix = [&keys, n](int a, int b) {
+        if (b < 0 || b >= n) {return -1;}
+        return countLeadingZeros(keys[a] ^ keys[b]);
+    };
+
+    // The node covers a range of keys starting at i, and extends in the direction of the
+    // neighbour sharing the longer prefix.
+    int direction = prefix(i, i + 1) > prefix(i, i - 1) ? 1 : -1;
+    int minimum = prefix(i, i - direction);
+
+    // Find the other end of the range with an exponential then binary search.
+    int maximum = 2;
+    while (prefix(i, i + maximum * direction) > minimum) {maximum *= 2;}
+
+    int length = 0;
+    for (int step = maximum / 2; step >= 1; step /= 2) {
+        if (prefix(i, i + (length + step) * direction) > minimum) {length += step;}
+    }
+
+    int j = i + length * direction;
+    int shared = prefix(i, j);
+
+    // Split the range where the prefix shared with i becomes shorter.
+    int split = 0;
+    for (int divisor = 2; ; divisor *= 2) {
+        int step = (length + divisor - 1) / divisor;
+        if (prefix(i, i + (split + step) * direction) > shared) {split += step;}
+        if (step <= 1) {break;}
+    }
+
+    int gamma = i + split * direction + std::min(direction, 0);
+    int left = std::min(i, j) == gamma ? n - 1 + gamma : gamma;
+    int right = std::max(i, j) == gamma + 1 ? n - 1 + gamma + 1 : gamma + 1;
+
+    this->nodes[i].left = left;
+    this->nodes[i].right = right;
+    this->parents[left] = i;
+    this->parents[right] = i;
+
+}
+
+void LinearBVH::refit(int leaf) {
+
+    // Only the second child to arrive at a node has both AABBs ready, the first stops there.
+    int index = this->parents[leaf];
+    while (index != NONE) {
+        if (this->arrivals[index].fetch_add(1, std::memory_order_acq_rel) == 0) {return;}
+        Node& node = this->nodes[index];
+        node.aabb = combine(this->nodes[node.left].aabb, this->nodes[node.right].aabb);
+        index = this->parents[index];
+    }
+
+}
+
+void LinearBVH::query(AABB region, std::vector<int>& result) {
+
+    this->build();
+    if (this->count == 0) {return;}
+
+    int stack[STACK_SIZE];
+    int size = 0;
+    stack[size++] = 0;
+
+    while (size > 0) {
+
+        const Node& node = this->nodes[stack[--size]];
+        if (!overlaps(node.aabb, region)) {continue;}
+
+        if (node.left == NONE) {
+            result.push_back(node.right);
+            continue;
+        }
+
+        stack[size++] = node.left;
+        stack[size++] = node.right;
+
+    }
+
+}
+
+void LinearBVH::getPairs(std::vector<Pair>& pairs) {
+
+    pairs.clear();
+    this->build();
+    int n = this->count;
+    if (n == 0) {return;}
+
+    int grain = this->getGrain(n);
+    this->buffers.resize((n + grain - 1) / grain);
+
+    // Query the tree with every leaf, only keeping leaves further along the curve so each pair is found once.
+    // Each chunk has its own buffer, so the pairs come out in the same order whatever ran them.
+    this->parallelFor(n, grain, [this, n, grain](int begin, int end) {
+
+        std::vector<Pair>& buffer = this->buffers[begin / grain];
+        buffer.clear();
+        int stack[STACK_SIZE];
+
+        for (int leaf = n - 1 + begin; leaf < n - 1 + end; leaf++) {
+
+            const Node& current = this->nodes[leaf];
+            int size = 0;
+            stack[size++] = 0;
+
+            while (size > 0) {
+
+                int index = stack[--size];
+                const Node& node = this->nodes[index];
+                if (!overlaps(node.aabb, current.aabb)) {continue;}
+
+                if (node.left == NONE) {
+                    if (index <= leaf) {continue;}
+                    buffer.push_back({std::min(node.right, current.right), std::max(node.right, current.right)});
+                    continue;
+                }
+
+                stack[size++] = node.left;
+                stack[size++] = node.right;
+
+            }
+
+        }
+
+    });
+
+    for (int k = 0; k < (n + grain - 1) / grain; k++) {
+        pairs.insert(pairs.end(), this->buffers[k].begin(), this->buffers[k].end());
+    }
+
+}
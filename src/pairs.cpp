@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include "pairs.hpp"
+
+namespace {
+
+    const int EMPTY = -1;
+    const int INITIAL_BITS = 4;
+
+    // Pairs per narrowphase job.
+    const int NARROWPHASE_GRAIN = 256;
+
+    void capture(const ShapeRef& shape, vec2* points) {
+
+        if (shape.type == ShapeType::CIRCLE) {
+            Circle* circle = shape.circle();
+            points[0] = circle->centre;
+            points[1] = circle->centre + vec2(circle->radius, 0.0f);
+            points[2] = circle->centre;
+            return;
+        }
+
+        Triangle* triangle = shape.triangle();
+        points[0] = triangle->a;
+        points[1] = triangle->b;
+        points[2] = triangle->c;
+
+    }
+
+}
+
+PairManager::PairManager() {
+    this->table.assign(1 << INITIAL_BITS, EMPTY);
+    this->stamp = 0;
+    this->shift = 64 - INITIAL_BITS;
+    this->awakeCount = 0;
+}
+
+int PairManager::getHome(int a, int b) const {
+    uint64_t key = ((uint64_t) (uint32_t) a << 32) | (uint32_t) b;
+    return (int) ((key * 0x9e3779b97f4a7c15ull) >> this->shift);
+}
+
+int PairManager::findSlot(int a, int b) const {
+
+    int mask = this->table.size() - 1;
+    for (int slot = this->getHome(a, b); ; slot = (slot + 1) & mask) {
+        int index = this->table[slot];
+        if (index == EMPTY) {return EMPTY;}
+        if (this->pairs[index].a == a && this->pairs[index].b == b) {return slot;}
+    }
+
+}
+
+int PairManager::find(int a, int b) const {
+    if (a > b) {std::swap(a, b);}
+    int slot = this->findSlot(a, b);
+    return slot == EMPTY ? EMPTY : this->table[slot];
+}
+
+void PairManager::grow() {
+
+    // Double the table and reinsert every pair.
+    this->table.assign(this->table.size() * 2, EMPTY);
+    this->shift--;
+
+    int mask = this->table.size() - 1;
+    for (int index = 0; index < (int) this->pairs.size(); index++) {
+        int slot = this->getHome(this->pairs[index].a, this->pairs[index].b);
+        while (this->table[slot] != EMPTY) {slot = (slot + 1) & mask;}
+        this->table[slot] = index;
+    }
+
+}
+
+void PairManager::swapPairs(int i, int j) {
+
+    if (i == j) {return;}
+
+    int slotI = this->findSlot(this->pairs[i].a, this->pairs[i].b);
+    int slotJ = this->findSlot(this->pairs[j].a, this->pairs[j].b);
+    this->table[slotI] = j;
+    this->table[slotJ] = i;
+
+    std::swap(this->pairs[i], this->pairs[j]);
+    std::swap(this->results[i], this->results[j]);
+    std::swap(this->impulses[i], this->impulses[j]);
+    std::swap(this->stamps[i], this->stamps[j]);
+    std::swap(this->snapshots[i], this->snapshots[j]);
+
+}
+
+void PairManager::wake(int index) {
+    if (index < this->awakeCount) {return;}
+    this->swapPairs(index, this->awakeCount);
+    this->awakeCount++;
+}
+
+void PairManager::sleep(int index) {
+    if (index >= this->awakeCount) {return;}
+    this->swapPairs(index, this->awakeCount - 1);
+    this->awakeCount--;
+}
+
+int PairManager::getAwakeCount() const {
+    return this->awakeCount;
+}
+
+bool PairManager::add(int a, int b) {
+
+    if (a > b) {std::swap(a, b);}
+    if (this->findSlot(a, b) != EMPTY) {return false;}
+
+    // Keep the table at most half full.
+    if (2 * (this->pairs.size() + 1) > this->table.size()) {this->grow();}
+
+    int mask = this->table.size() - 1;
+    int slot = this->getHome(a, b);
+    while (this->table[slot] != EMPTY) {slot = (slot + 1) & mask;}
+
+    this->table[slot] = this->pairs.size();
+    this->pairs.push_back({a, b});
+    this->results.push_back({false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0});
+    this->impulses.push_back({0, 0.0f, 0.0f});
+    this->stamps.push_back(this->stamp);
+    this->snapshots.push_back({{}, false});
+    this->begun.push_back({a, b});
+
+    // New pairs are awake, so swap the pair into the awake range.
+    this->wake(this->pairs.size() - 1);
+    return true;
+
+}
+
+bool PairManager::remove(int a, int b) {
+
+    if (a > b) {std::swap(a, b);}
+    int slot = this->findSlot(a, b);
+    if (slot == EMPTY) {return false;}
+
+    // Move an awake pair to the end of the awake range first, so the range stays contiguous.
+    int index = this->table[slot];
+    if (index < this->awakeCount) {
+        this->sleep(index);
+        index = this->awakeCount;
+    }
+
+    int mask = this->table.size() - 1;
+
+    // Shift later entries of the probe sequence back, so no lookup runs into the gap.
+    int next = slot;
+    while (true) {
+        next = (next + 1) & mask;
+        int moved = this->table[next];
+        if (moved == EMPTY) {break;}
+        int home = this->getHome(this->pairs[moved].a, this->pairs[moved].b);
+        bool between = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+        if (between) {continue;}
+        this->table[slot] = moved;
+        slot = next;
+    }
+    this->table[slot] = EMPTY;
+
+    // Swap the last pair into the removed index.
+    int last = this->pairs.size() - 1;
+    if (index != last) {
+        this->table[this->findSlot(this->pairs[last].a, this->pairs[last].b)] = index;
+        this->pairs[index] = this->pairs[last];
+        this->results[index] = this->results[last];
+        this->impulses[index] = this->impulses[last];
+        this->stamps[index] = this->stamps[last];
+        this->snapshots[index] = this->snapshots[last];
+    }
+
+    this->pairs.pop_back();
+    this->results.pop_back();
+    this->impulses.pop_back();
+    this->stamps.pop_back();
+    this->snapshots.pop_back();
+    this->ended.push_back({a, b});
+    return true;
+
+}
+
+void PairManager::clearEvents() {
+    this->begun.clear();
+    this->ended.clear();
+}
+
+void PairManager::update(const std::vector<Pair>& current) {
+
+    this->clearEvents();
+    this->stamp++;
+
+    // Mark every pair still reported, adding the new ones.
+    for (Pair pair : current) {
+        int index = this->find(pair.a, pair.b);
+        if (index == EMPTY) {
+            this->add(pair.a, pair.b);
+            continue;
+        }
+        this->stamps[index] = this->stamp;
+    }
+
+    // Then remove the rest. Going backwards, the pair swapped into a removed index is already marked.
+    for (int index = (int) this->pairs.size() - 1; index >= 0; index--) {
+        if (this->stamps[index] == this->stamp) {continue;}
+        Pair pair = this->pairs[index];
+        this->remove(pair.a, pair.b);
+    }
+
+}
+
+void PairManager::updateAwake(const std::vector<Pair>& current) {
+
+    this->clearEvents();
+    this->stamp++;
+
+    // Every pair reported has an awake shape, so it is woken if it was sleeping.
+    for (Pair pair : current) {
+        int index = this->find(pair.a, pair.b);
+        if (index == EMPTY) {
+            this->add(pair.a, pair.b);
+            continue;
+        }
+        this->stamps[index] = this->stamp;
+        this->wake(index);
+    }
+
+    // Only awake pairs can have ended. Removing one moves an already visited awake pair into its index.
+    for (int index = this->awakeCount - 1; index >= 0; index--) {
+        if (this->stamps[index] == this->stamp) {continue;}
+        Pair pair = this->pairs[index];
+        this->remove(pair.a, pair.b);
+    }
+
+}
+
+void PairManager::update(const std::vector<Pair>& begun, const std::vector<Pair>& ended) {
+    this->clearEvents();
+    for (Pair pair : ended) {this->remove(pair.a, pair.b);}
+    for (Pair pair : begun) {this->add(pair.a, pair.b);}
+}
+
+void PairManager::collide(const ShapeRef* shapes) {
+    this->collide(shapes, 0.0f, nullptr);
+}
+
+void PairManager::collide(const ShapeRef* shapes, float tolerance) {
+    this->collide(shapes, tolerance, nullptr);
+}
+
+void PairManager::collide(const ShapeRef* shapes, float tolerance, JobSystem* jobs) {
+
+    int n = this->awakeCount;
+
+    // Every pair writes only its own entries, so the chunks need no synchronisation.
+    if (jobs == nullptr) {this->collideRange(shapes, tolerance, 0, n);}
+    else {
+        jobs->parallelFor(n, NARROWPHASE_GRAIN, [this, shapes, tolerance](int begin, int end) {
+            this->collideRange(shapes, tolerance, begin, end);
+        });
+    }
+
+    this->gather(jobs);
+
+}
+
+void PairManager::collideRange(const ShapeRef* shapes, float tolerance, int begin, int end) {
+
+    for (int index = begin; index < end; index++) {
+
+        Pair pair = this->pairs[index];
+        vec2 points[6];
+        capture(shapes[pair.a], points);
+        capture(shapes[pair.b], points + 3);
+
+        if (!this->reuse(index, points, tolerance)) {
+            this->results[index] = getCollision(shapes[pair.a], shapes[pair.b]);
+        }
+
+    }
+
+}
+
+bool PairManager::reuse(int index, const vec2* points, float tolerance) {
+
+    Snapshot& snapshot = this->snapshots[index];
+    CollisionResult& result = this->results[index];
+
+    // Reuse the result if every point has moved by the same offset as the first.
+    if (snapshot.valid) {
+
+        vec2 offset = points[0] - snapshot.points[0];
+        bool unchanged = true;
+        for (int i = 1; i < 6 && unchanged; i++) {
+            vec2 difference = points[i] - snapshot.points[i] - offset;
+            unchanged = glm::dot(difference, difference) <= tolerance * tolerance;
+        }
+
+        // Move the stored pose with the result, so the error never grows past the tolerance.
+        if (unchanged) {
+            for (int i = 0; i < 6; i++) {snapshot.points[i] += offset;}
+            if (result.colliding) {result.point += offset;}
+            return true;
+        }
+
+    }
+
+    for (int i = 0; i < 6; i++) {snapshot.points[i] = points[i];}
+    snapshot.valid = true;
+    return false;
+
+}
+
+void PairManager::gather(JobSystem* jobs) {
+
+    int n = this->awakeCount;
+    this->colliding.clear();
+
+    if (jobs == nullptr) {
+        this->gatherRange(0, n, this->colliding);
+        return;
+    }
+
+    // Each chunk lists its colliding pairs in a buffer of its own, joined in chunk order.
+    int chunks = (n + NARROWPHASE_GRAIN - 1) / NARROWPHASE_GRAIN;
+    if ((int) this->buffers.size() < chunks) {this->buffers.resize(chunks);}
+
+    jobs->parallelFor(n, NARROWPHASE_GRAIN, [this](int begin, int end) {
+        std::vector<int>& buffer = this->buffers[begin / NARROWPHASE_GRAIN];
+        buffer.clear();
+        this->gatherRange(begin, end, buffer);
+    });
+
+    for (int k = 0; k < chunks; k++) {
+        this->colliding.insert(this->colliding.end(), this->buffers[k].begin(), this->buffers[k].end());
+    }
+
+}
+
+void PairManager::gatherRange(int begin, int end, std::vector<int>& colliding) {
+
+    for (int index = begin; index < end; index++) {
+
+        // A pair that has come apart keeps no impulses.
+        if (!this->results[index].colliding) {
+            this->impulses[index].normal = 0.0f;
+            this->impulses[index].tangent = 0.0f;
+            continue;
+        }
+
+        colliding.push_back(index);
+
+    }
+
+}
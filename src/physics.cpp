@@ -0,0 +1,681 @@
+#include <cmath>
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include "physics.hpp"
+#include "simd.hpp"
+
+namespace {
+
+    const float PI = 3.14159265358979f;
+    const int NONE = -1;
+
+    // Colours beyond this many go to the overflow range, so a body's colours fit in one mask.
+    const int MAX_COLOURS = 24;
+
+    // Contacts per solver job. A multiple of the SIMD width, so jobs split no batch.
+    const int SOLVER_GRAIN = 64;
+
+    template <typename T>
+    void permute(std::vector<T>& values, const std::vector<int>& order, std::vector<T>& scratch) {
+        scratch.resize(values.size());
+        for (int i = 0; i < (int) order.size(); i++) {scratch[order[i]] = values[i];}
+        values.swap(scratch);
+    }
+
+    float cross(vec2 a, vec2 b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    // Gets the lowest colour missing from a mask of used colours, which must not be full.
+    int getFreeColour(uint32_t used) {
+        int colour = 0;
+        while (used & (1u << colour)) {colour++;}
+        return colour;
+    }
+
+}
+
+Physics::Physics(Broadphase* broadphase, int iterations) : Physics(broadphase, iterations, nullptr) {}
+
+Physics::Physics(Broadphase* broadphase, int iterations, JobSystem* jobs) : world(broadphase, jobs) {
+    this->jobs = jobs;
+    this->gravity = vec2(0.0f, 0.0f);
+    this->friction = 0.4f;
+    this->baumgarte = 0.2f;
+    this->slop = 0.005f;
+    this->iterations = iterations;
+    this->warmStarting = true;
+    this->sleeping = true;
+    this->sleepVelocity = 0.05f;
+    this->sleepAngularVelocity = 0.05f;
+    this->sleepDelay = 0.5f;
+}
+
+void Physics::attach(Handle handle, float mass, float inertia) {
+
+    if (!this->world.contains(handle)) {return;}
+    int slot = this->world.getSlot(handle);
+    if (slot >= (int) this->inverseMasses.size()) {
+        this->inverseMasses.resize(slot + 1, 0.0f);
+        this->inverseInertias.resize(slot + 1, 0.0f);
+        this->velocityX.resize(slot + 1, 0.0f);
+        this->velocityY.resize(slot + 1, 0.0f);
+        this->angularVelocities.resize(slot + 1, 0.0f);
+        this->sleepTimes.resize(slot + 1, 0.0f);
+        this->awakeIndices.resize(slot + 1, NONE);
+        this->islandNext.resize(slot + 1, NONE);
+        this->parents.resize(slot + 1, NONE);
+        this->islandTimes.resize(slot + 1, 0.0f);
+        this->colourMasks.resize(slot + 1, 0);
+    }
+
+    // A reused slot may still be in the awake list.
+    if (this->awakeIndices[slot] != NONE) {
+        int last = this->awake.back();
+        this->awake[this->awakeIndices[slot]] = last;
+        this->awakeIndices[last] = this->awakeIndices[slot];
+        this->awake.pop_back();
+        this->awakeIndices[slot] = NONE;
+    }
+
+    this->inverseMasses[slot] = mass > 0.0f ? 1.0f / mass : 0.0f;
+    this->inverseInertias[slot] = inertia > 0.0f ? 1.0f / inertia : 0.0f;
+    this->velocityX[slot] = 0.0f;
+    this->velocityY[slot] = 0.0f;
+    this->angularVelocities[slot] = 0.0f;
+    this->sleepTimes[slot] = 0.0f;
+    this->islandNext[slot] = NONE;
+
+    // Static bodies are never awake, and the world only looks for the pairs of awake bodies.
+    if (mass > 0.0f) {
+        this->awakeIndices[slot] = this->awake.size();
+        this->awake.push_back(slot);
+    }
+    this->world.setAwake(handle, mass > 0.0f);
+
+}
+
+Handle Physics::add(Circle circle, float density) {
+    float mass = density * PI * circle.radius * circle.radius;
+    Handle handle = this->world.add(circle);
+    this->attach(handle, mass, 0.5f * mass * circle.radius * circle.radius);
+    return handle;
+}
+
+Handle Physics::add(const Triangle& triangle, float density) {
+
+    // The second moment of area of a triangle about its centroid is area / 12 times the
+    // sum of the squared distances of its vertices from the centroid.
+    float mass = density * 0.5f * fabsf(cross(triangle.b - triangle.a, triangle.c - triangle.a));
+    vec2 centroid = triangle.centroid();
+    vec2 da = triangle.a - centroid;
+    vec2 db = triangle.b - centroid;
+    vec2 dc = triangle.c - centroid;
+    float inertia = mass / 12.0f * (glm::dot(da, da) + glm::dot(db, db) + glm::dot(dc, dc));
+
+    Handle handle = this->world.add(triangle);
+    this->attach(handle, mass, inertia);
+    return handle;
+
+}
+
+void Physics::remove(Handle handle) {
+    if (!this->world.contains(handle)) {return;}
+    this->wakeSlot(this->world.getSlot(handle));
+    this->attach(handle, 0.0f, 0.0f);
+    this->world.remove(handle);
+}
+
+vec2 Physics::getSlotCentre(int slot) const {
+    Handle handle = this->world.getHandle(slot);
+    if (this->world.getType(handle) == ShapeType::CIRCLE) {return this->world.getCircle(handle).centre;}
+    return this->world.getTriangle(handle).centroid();
+}
+
+vec2 Physics::getCentre(Handle handle) const {
+    return this->getSlotCentre(this->world.getSlot(handle));
+}
+
+float Physics::getMass(Handle handle) const {
+    float inverseMass = this->inverseMasses[this->world.getSlot(handle)];
+    return inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f;
+}
+
+vec2 Physics::getVelocity(Handle handle) const {
+    int slot = this->world.getSlot(handle);
+    return vec2(this->velocityX[slot], this->velocityY[slot]);
+}
+
+float Physics::getAngularVelocity(Handle handle) const {
+    return this->angularVelocities[this->world.getSlot(handle)];
+}
+
+bool Physics::isAwake(Handle handle) const {
+    return this->awakeIndices[this->world.getSlot(handle)] != NONE;
+}
+
+int Physics::getAwakeCount() const {
+    return this->awake.size();
+}
+
+void Physics::wake(Handle handle) {
+    this->wakeSlot(this->world.getSlot(handle));
+}
+
+void Physics::wakeSlot(int slot) {
+
+    if (this->inverseMasses[slot] == 0.0f || this->awakeIndices[slot] != NONE) {return;}
+
+    // Wake every body of the island, following the ring linking them.
+    int body = slot;
+    do {
+        int next = this->islandNext[body];
+        this->awakeIndices[body] = this->awake.size();
+        this->awake.push_back(body);
+        this->sleepTimes[body] = 0.0f;
+        this->islandNext[body] = NONE;
+        this->world.setAwake(this->world.getHandle(body), true);
+        body = next;
+    } while (body != slot);
+
+}
+
+void Physics::setVelocity(Handle handle, vec2 velocity) {
+    int slot = this->world.getSlot(handle);
+    if (this->inverseMasses[slot] == 0.0f) {return;}
+    this->wakeSlot(slot);
+    this->velocityX[slot] = velocity.x;
+    this->velocityY[slot] = velocity.y;
+}
+
+void Physics::setAngularVelocity(Handle handle, float angularVelocity) {
+    int slot = this->world.getSlot(handle);
+    if (this->inverseMasses[slot] == 0.0f) {return;}
+    this->wakeSlot(slot);
+    this->angularVelocities[slot] = angularVelocity;
+}
+
+void Physics::applyImpulse(Handle handle, vec2 impulse, vec2 point) {
+    int slot = this->world.getSlot(handle);
+    if (this->inverseMasses[slot] == 0.0f) {return;}
+    this->wakeSlot(slot);
+    this->velocityX[slot] += this->inverseMasses[slot] * impulse.x;
+    this->velocityY[slot] += this->inverseMasses[slot] * impulse.y;
+    this->angularVelocities[slot] += this->inverseInertias[slot] * cross(point - this->getSlotCentre(slot), impulse);
+}
+
+void Physics::prepare(float dt) {
+
+    Contacts& c = this->contacts;
+    c.pair.clear();
+    c.a.clear();
+    c.b.clear();
+    c.normalX.clear();
+    c.normalY.clear();
+    c.aX.clear();
+    c.aY.clear();
+    c.bX.clear();
+    c.bY.clear();
+    c.normalMass.clear();
+    c.tangentMass.clear();
+    c.bias.clear();
+    c.normalImpulse.clear();
+    c.tangentImpulse.clear();
+
+    const PairManager& pairs = this->world.pairs;
+    for (int i : pairs.colliding) {
+
+        const CollisionResult& result = pairs.results[i];
+        const ContactImpulse& stored = pairs.impulses[i];
+
+        int a = pairs.pairs[i].a;
+        int b = pairs.pairs[i].b;
+        float inverseMassA = this->inverseMasses[a];
+        float inverseMassB = this->inverseMasses[b];
+        if (inverseMassA + inverseMassB == 0.0f) {continue;}
+
+        // Contacts of sleeping bodies keep their impulses for when they wake.
+        if (this->awakeIndices[a] == NONE && this->awakeIndices[b] == NONE) {continue;}
+
+        vec2 normal = result.normal;
+        vec2 tangent = vec2(-normal.y, normal.x);
+        vec2 ra = result.point - this->getSlotCentre(a);
+        vec2 rb = result.point - this->getSlotCentre(b);
+
+        // The effective mass of each direction, seen from the contact point.
+        float rna = cross(ra, normal), rnb = cross(rb, normal);
+        float rta = cross(ra, tangent), rtb = cross(rb, tangent);
+        float normalMass = inverseMassA + inverseMassB + this->inverseInertias[a] * rna * rna + this->inverseInertias[b] * rnb * rnb;
+        float tangentMass = inverseMassA + inverseMassB + this->inverseInertias[a] * rta * rta + this->inverseInertias[b] * rtb * rtb;
+
+        // The depth is half of the overlap.
+        float overlap = 2.0f * result.depth;
+
+        // Start from the impulses of the last step if the same features are still touching.
+        float normalImpulse = 0.0f, tangentImpulse = 0.0f;
+        if (this->warmStarting && stored.feature == result.feature) {
+            normalImpulse = stored.normal;
+            tangentImpulse = stored.tangent;
+            vec2 impulse = normal * normalImpulse + tangent * tangentImpulse;
+            this->velocityX[a] += inverseMassA * impulse.x;
+            this->velocityY[a] += inverseMassA * impulse.y;
+            this->angularVelocities[a] += this->inverseInertias[a] * cross(ra, impulse);
+            this->velocityX[b] -= inverseMassB * impulse.x;
+            this->velocityY[b] -= inverseMassB * impulse.y;
+            this->angularVelocities[b] -= this->inverseInertias[b] * cross(rb, impulse);
+        }
+
+        c.pair.push_back(i);
+        c.a.push_back(a);
+        c.b.push_back(b);
+        c.normalX.push_back(normal.x);
+        c.normalY.push_back(normal.y);
+        c.aX.push_back(ra.x);
+        c.aY.push_back(ra.y);
+        c.bX.push_back(rb.x);
+        c.bY.push_back(rb.y);
+        c.normalMass.push_back(1.0f / normalMass);
+        c.tangentMass.push_back(1.0f / tangentMass);
+        c.bias.push_back(this->baumgarte / dt * std::max(overlap - this->slop, 0.0f));
+        c.normalImpulse.push_back(normalImpulse);
+        c.tangentImpulse.push_back(tangentImpulse);
+
+    }
+
+    this->colour();
+
+}
+
+void Physics::colour() {
+
+    Contacts& c = this->contacts;
+    int count = c.a.size();
+
+    // Greedily give each contact the lowest colour neither of its moving bodies has yet.
+    // Static bodies are never written by the solver, so they take no colours.
+    for (int slot : this->awake) {this->colourMasks[slot] = 0;}
+    this->colours.resize(count);
+    c.offsets.assign(MAX_COLOURS + 2, 0);
+
+    for (int i = 0; i < count; i++) {
+
+        int a = c.a[i];
+        int b = c.b[i];
+        uint32_t used = 0;
+        if (this->inverseMasses[a] != 0.0f) {used |= this->colourMasks[a];}
+        if (this->inverseMasses[b] != 0.0f) {used |= this->colourMasks[b];}
+
+        int colour = MAX_COLOURS;
+        if (used != (1u << MAX_COLOURS) - 1) {
+            colour = getFreeColour(used);
+            uint32_t bit = 1u << colour;
+            if (this->inverseMasses[a] != 0.0f) {this->colourMasks[a] |= bit;}
+            if (this->inverseMasses[b] != 0.0f) {this->colourMasks[b] |= bit;}
+        }
+
+        this->colours[i] = colour;
+        c.offsets[colour + 1]++;
+
+    }
+
+    // Sort the contacts by colour, keeping their order within each colour.
+    for (int k = 0; k <= MAX_COLOURS; k++) {c.offsets[k + 1] += c.offsets[k];}
+    // The next free index of each colour goes in the scratch array, which permute reuses after.
+    std::vector<int>& order = this->colours;
+    std::vector<int>& next = this->intScratch;
+    next.assign(c.offsets.begin(), c.offsets.end() - 1);
+    for (int i = 0; i < count; i++) {order[i] = next[order[i]]++;}
+
+    permute(c.pair, order, this->intScratch);
+    permute(c.a, order, this->intScratch);
+    permute(c.b, order, this->intScratch);
+    permute(c.normalX, order, this->floatScratch);
+    permute(c.normalY, order, this->floatScratch);
+    permute(c.aX, order, this->floatScratch);
+    permute(c.aY, order, this->floatScratch);
+    permute(c.bX, order, this->floatScratch);
+    permute(c.bY, order, this->floatScratch);
+    permute(c.normalMass, order, this->floatScratch);
+    permute(c.tangentMass, order, this->floatScratch);
+    permute(c.bias, order, this->floatScratch);
+    permute(c.normalImpulse, order, this->floatScratch);
+    permute(c.tangentImpulse, order, this->floatScratch);
+
+}
+
+void Physics::solve() {
+
+    const Contacts& c = this->contacts;
+
+    // Within a colour no two contacts share a moving body, so each colour is split across the
+    // job system. The overflow range after the last colour is always solved in order.
+    for (int iteration = 0; iteration < this->iterations; iteration++) {
+
+        for (int k = 0; k < MAX_COLOURS; k++) {
+            int begin = c.offsets[k];
+            int end = c.offsets[k + 1];
+            if (this->jobs == nullptr) {
+                this->solveRange(begin, end);
+                continue;
+            }
+            this->jobs->parallelFor(end - begin, SOLVER_GRAIN, [this, begin](int first, int last) {
+                this->solveRange(begin + first, begin + last);
+            });
+        }
+
+        for (int i = c.offsets[MAX_COLOURS]; i < c.offsets[MAX_COLOURS + 1]; i++) {this->solveContact(i);}
+
+    }
+
+}
+
+// Solves a range of contacts sharing no moving body, a batch of lanes at a time where possible.
+void Physics::solveRange(int begin, int end) {
+    int i = begin;
+    #ifdef TRIP2D_LANES
+    for (; i + TRIP2D_LANES <= end; i += TRIP2D_LANES) {this->solveBatch(i);}
+    #endif
+    for (; i < end; i++) {this->solveContact(i);}
+}
+
+void Physics::solveContact(int i) {
+
+    Contacts& c = this->contacts;
+    int a = c.a[i];
+    int b = c.b[i];
+    float inverseMassA = this->inverseMasses[a], inverseInertiaA = this->inverseInertias[a];
+    float inverseMassB = this->inverseMasses[b], inverseInertiaB = this->inverseInertias[b];
+    float nx = c.normalX[i], ny = c.normalY[i];
+    float tx = -ny, ty = nx;
+
+    float vax = this->velocityX[a], vay = this->velocityY[a], wa = this->angularVelocities[a];
+    float vbx = this->velocityX[b], vby = this->velocityY[b], wb = this->angularVelocities[b];
+
+    // Relative velocity of A against B at the contact point.
+    float dvx = (vax - wa * c.aY[i]) - (vbx - wb * c.bY[i]);
+    float dvy = (vay + wa * c.aX[i]) - (vby + wb * c.bX[i]);
+
+    // Friction, limited by the normal impulse so far.
+    float limit = this->friction * c.normalImpulse[i];
+    float lambda = -c.tangentMass[i] * (dvx * tx + dvy * ty);
+    float impulse = std::min(std::max(c.tangentImpulse[i] + lambda, -limit), limit);
+    lambda = impulse - c.tangentImpulse[i];
+    c.tangentImpulse[i] = impulse;
+
+    float px = lambda * tx, py = lambda * ty;
+    vax += inverseMassA * px;
+    vay += inverseMassA * py;
+    wa += inverseInertiaA * (c.aX[i] * py - c.aY[i] * px);
+    vbx -= inverseMassB * px;
+    vby -= inverseMassB * py;
+    wb -= inverseInertiaB * (c.bX[i] * py - c.bY[i] * px);
+
+    // Then the normal, which may only push the bodies apart.
+    dvx = (vax - wa * c.aY[i]) - (vbx - wb * c.bY[i]);
+    dvy = (vay + wa * c.aX[i]) - (vby + wb * c.bX[i]);
+
+    lambda = c.normalMass[i] * (c.bias[i] - (dvx * nx + dvy * ny));
+    impulse = std::max(c.normalImpulse[i] + lambda, 0.0f);
+    lambda = impulse - c.normalImpulse[i];
+    c.normalImpulse[i] = impulse;
+
+    px = lambda * nx;
+    py = lambda * ny;
+    vax += inverseMassA * px;
+    vay += inverseMassA * py;
+    wa += inverseInertiaA * (c.aX[i] * py - c.aY[i] * px);
+    vbx -= inverseMassB * px;
+    vby -= inverseMassB * py;
+    wb -= inverseInertiaB * (c.bX[i] * py - c.bY[i] * px);
+
+    // Static bodies are shared between contacts of the same colour, so they are never written.
+    if (inverseMassA != 0.0f) {
+        this->velocityX[a] = vax;
+        this->velocityY[a] = vay;
+        this->angularVelocities[a] = wa;
+    }
+
+    if (inverseMassB != 0.0f) {
+        this->velocityX[b] = vbx;
+        this->velocityY[b] = vby;
+        this->angularVelocities[b] = wb;
+    }
+
+}
+
+#ifdef TRIP2D_LANES
+
+// Mirrors solveContact for the contacts from i to i + TRIP2D_LANES, which must share no moving body.
+// Contact data is loaded straight from its arrays, while body state is gathered into lanes and
+// scattered back afterwards.
+void Physics::solveBatch(int i) {
+
+    // Physics has its own add and store, which would hide these.
+    using namespace Simd;
+    using Simd::add;
+    using Simd::store;
+    Contacts& c = this->contacts;
+
+    float inverseMassesA[TRIP2D_LANES], inverseInertiasA[TRIP2D_LANES];
+    float inverseMassesB[TRIP2D_LANES], inverseInertiasB[TRIP2D_LANES];
+    float velocitiesAX[TRIP2D_LANES], velocitiesAY[TRIP2D_LANES], angularA[TRIP2D_LANES];
+    float velocitiesBX[TRIP2D_LANES], velocitiesBY[TRIP2D_LANES], angularB[TRIP2D_LANES];
+
+    for (int lane = 0; lane < TRIP2D_LANES; lane++) {
+        int a = c.a[i + lane];
+        int b = c.b[i + lane];
+        inverseMassesA[lane] = this->inverseMasses[a];
+        inverseInertiasA[lane] = this->inverseInertias[a];
+        inverseMassesB[lane] = this->inverseMasses[b];
+        inverseInertiasB[lane] = this->inverseInertias[b];
+        velocitiesAX[lane] = this->velocityX[a];
+        velocitiesAY[lane] = this->velocityY[a];
+        angularA[lane] = this->angularVelocities[a];
+        velocitiesBX[lane] = this->velocityX[b];
+        velocitiesBY[lane] = this->velocityY[b];
+        angularB[lane] = this->angularVelocities[b];
+    }
+
+    floats inverseMassA = load(inverseMassesA), inverseInertiaA = load(inverseInertiasA);
+    floats inverseMassB = load(inverseMassesB), inverseInertiaB = load(inverseInertiasB);
+    floats vax = load(velocitiesAX), vay = load(velocitiesAY), wa = load(angularA);
+    floats vbx = load(velocitiesBX), vby = load(velocitiesBY), wb = load(angularB);
+
+    floats nx = load(&c.normalX[i]), ny = load(&c.normalY[i]);
+    floats tx = sub(splat(0.0f), ny), ty = nx;
+    floats aX = load(&c.aX[i]), aY = load(&c.aY[i]);
+    floats bX = load(&c.bX[i]), bY = load(&c.bY[i]);
+    floats normalImpulse = load(&c.normalImpulse[i]);
+    floats tangentImpulse = load(&c.tangentImpulse[i]);
+
+    // Relative velocity of A against B at the contact point.
+    floats dvx = sub(sub(vax, mul(wa, aY)), sub(vbx, mul(wb, bY)));
+    floats dvy = sub(add(vay, mul(wa, aX)), add(vby, mul(wb, bX)));
+
+    // Friction, limited by the normal impulse so far.
+    floats limit = mul(splat(this->friction), normalImpulse);
+    floats lambda = mul(sub(splat(0.0f), load(&c.tangentMass[i])), add(mul(dvx, tx), mul(dvy, ty)));
+    floats impulse = min(max(add(tangentImpulse, lambda), sub(splat(0.0f), limit)), limit);
+    lambda = sub(impulse, tangentImpulse);
+    store(&c.tangentImpulse[i], impulse);
+
+    floats px = mul(lambda, tx), py = mul(lambda, ty);
+    vax = add(vax, mul(inverseMassA, px));
+    vay = add(vay, mul(inverseMassA, py));
+    wa = add(wa, mul(inverseInertiaA, sub(mul(aX, py), mul(aY, px))));
+    vbx = sub(vbx, mul(inverseMassB, px));
+    vby = sub(vby, mul(inverseMassB, py));
+    wb = sub(wb, mul(inverseInertiaB, sub(mul(bX, py), mul(bY, px))));
+
+    // Then the normal, which may only push the bodies apart.
+    dvx = sub(sub(vax, mul(wa, aY)), sub(vbx, mul(wb, bY)));
+    dvy = sub(add(vay, mul(wa, aX)), add(vby, mul(wb, bX)));
+
+    lambda = mul(load(&c.normalMass[i]), sub(load(&c.bias[i]), add(mul(dvx, nx), mul(dvy, ny))));
+    impulse = max(add(normalImpulse, lambda), splat(0.0f));
+    lambda = sub(impulse, normalImpulse);
+    store(&c.normalImpulse[i], impulse);
+
+    px = mul(lambda, nx);
+    py = mul(lambda, ny);
+    vax = add(vax, mul(inverseMassA, px));
+    vay = add(vay, mul(inverseMassA, py));
+    wa = add(wa, mul(inverseInertiaA, sub(mul(aX, py), mul(aY, px))));
+    vbx = sub(vbx, mul(inverseMassB, px));
+    vby = sub(vby, mul(inverseMassB, py));
+    wb = sub(wb, mul(inverseInertiaB, sub(mul(bX, py), mul(bY, px))));
+
+    store(velocitiesAX, vax);
+    store(velocitiesAY, vay);
+    store(angularA, wa);
+    store(velocitiesBX, vbx);
+    store(velocitiesBY, vby);
+    store(angularB, wb);
+
+    // Static bodies may appear in several lanes, so they are never written.
+    for (int lane = 0; lane < TRIP2D_LANES; lane++) {
+        int a = c.a[i + lane];
+        int b = c.b[i + lane];
+        if (inverseMassesA[lane] != 0.0f) {
+            this->velocityX[a] = velocitiesAX[lane];
+            this->velocityY[a] = velocitiesAY[lane];
+            this->angularVelocities[a] = angularA[lane];
+        }
+        if (inverseMassesB[lane] != 0.0f) {
+            this->velocityX[b] = velocitiesBX[lane];
+            this->velocityY[b] = velocitiesBY[lane];
+            this->angularVelocities[b] = angularB[lane];
+        }
+    }
+
+}
+
+#endif
+
+void Physics::store() {
+
+    const Contacts& c = this->contacts;
+    PairManager& pairs = this->world.pairs;
+
+    for (int i = 0; i < (int) c.pair.size(); i++) {
+        int pair = c.pair[i];
+        pairs.impulses[pair] = {pairs.results[pair].feature, c.normalImpulse[i], c.tangentImpulse[i]};
+    }
+
+}
+
+void Physics::integrate(float dt) {
+
+    for (int slot : this->awake) {
+
+        Handle handle = this->world.getHandle(slot);
+        vec2 velocity = vec2(this->velocityX[slot], this->velocityY[slot]);
+
+        // Turn and move each body in one go, so its broadphase proxy is only updated once.
+        float angle = this->angularVelocities[slot] * dt;
+        if (this->world.getType(handle) == ShapeType::TRIANGLE && angle != 0.0f) {
+            this->world.transform(handle, Rotation(cosf(angle), sinf(angle)), this->getSlotCentre(slot), velocity * dt);
+            continue;
+        }
+
+        this->world.translate(handle, velocity * dt);
+
+    }
+
+}
+
+void Physics::wakeTouched() {
+
+    // A sleeping body touched by an awake one wakes with its island.
+    const PairManager& pairs = this->world.pairs;
+    for (int i : pairs.colliding) {
+        int a = pairs.pairs[i].a;
+        int b = pairs.pairs[i].b;
+        if (this->awakeIndices[a] != NONE) {this->wakeSlot(b);}
+        else if (this->awakeIndices[b] != NONE) {this->wakeSlot(a);}
+    }
+
+}
+
+int Physics::findIsland(int slot) {
+    while (this->parents[slot] != slot) {
+        this->parents[slot] = this->parents[this->parents[slot]];
+        slot = this->parents[slot];
+    }
+    return slot;
+}
+
+void Physics::sleep(float dt) {
+
+    float velocity2 = this->sleepVelocity * this->sleepVelocity;
+
+    // Time how long each awake body has been still, and start each in an island of its own.
+    for (int slot : this->awake) {
+        float speed2 = this->velocityX[slot] * this->velocityX[slot] + this->velocityY[slot] * this->velocityY[slot];
+        bool still = speed2 <= velocity2 && fabsf(this->angularVelocities[slot]) <= this->sleepAngularVelocity;
+        this->sleepTimes[slot] = still ? this->sleepTimes[slot] + dt : 0.0f;
+        this->islandTimes[slot] = this->sleepTimes[slot];
+        this->parents[slot] = slot;
+    }
+
+    // Join the islands of every pair of moving bodies in contact. Static bodies do not join islands,
+    // so a pile resting on the ground is not one island with everything else on the ground.
+    const Contacts& c = this->contacts;
+    for (int i = 0; i < (int) c.a.size(); i++) {
+        if (this->inverseMasses[c.a[i]] == 0.0f || this->inverseMasses[c.b[i]] == 0.0f) {continue;}
+        int a = this->findIsland(c.a[i]);
+        int b = this->findIsland(c.b[i]);
+        if (a != b) {this->parents[std::max(a, b)] = std::min(a, b);}
+    }
+
+    // An island sleeps once all of its bodies have been still for long enough.
+    for (int slot : this->awake) {
+        int root = this->findIsland(slot);
+        this->islandTimes[root] = std::min(this->islandTimes[root], this->sleepTimes[slot]);
+    }
+
+    // Link the bodies of each sleeping island into a ring, then drop them from the awake list.
+    for (int slot : this->awake) {
+        int root = this->findIsland(slot);
+        if (this->islandTimes[root] < this->sleepDelay) {continue;}
+        if (this->islandNext[root] == NONE) {this->islandNext[root] = root;}
+        if (slot == root) {continue;}
+        this->islandNext[slot] = this->islandNext[root];
+        this->islandNext[root] = slot;
+    }
+
+    int count = 0;
+    for (int slot : this->awake) {
+        if (this->islandNext[slot] != NONE) {
+            this->awakeIndices[slot] = NONE;
+            this->velocityX[slot] = 0.0f;
+            this->velocityY[slot] = 0.0f;
+            this->angularVelocities[slot] = 0.0f;
+            this->world.setAwake(this->world.getHandle(slot), false);
+            continue;
+        }
+        this->awakeIndices[slot] = count;
+        this->awake[count++] = slot;
+    }
+    this->awake.resize(count);
+
+}
+
+void Physics::step(float dt) {
+
+    if (dt <= 0.0f) {return;}
+
+    for (int slot : this->awake) {
+        this->velocityX[slot] += this->gravity.x * dt;
+        this->velocityY[slot] += this->gravity.y * dt;
+    }
+
+    this->world.collide();
+    this->wakeTouched();
+    this->prepare(dt);
+    this->solve();
+    this->store();
+    this->integrate(dt);
+    if (this->sleeping) {this->sleep(dt);}
+
+}
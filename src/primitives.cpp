@@ -1,24 +1,37 @@
 #include <cmath>
 #include <algorithm>
+#include <glm/geometric.hpp>
 #include "primitives.hpp"
 
-void rotateVector(vec2& vec, float degrees, vec2 origin) {
+Rotation::Rotation(float degrees) {
+    float radians = degrees * (float) M_PI / 180.0f;
+    this->cos = cosf(radians);
+    this->sin = sinf(radians);
+}
 
-    float x = vec.x - origin.x;
-    float y = vec.y - origin.y;
-    float radians = degrees * M_PI / 180.0f;
+Rotation::Rotation(float cos, float sin) {
+    this->cos = cos;
+    this->sin = sin;
+}
 
-    vec.x = origin.x + ((x * (float) cos(radians)) - (y * (float) sin(radians)));
-    vec.y = origin.y + ((x * (float) sin(radians)) + (y * (float) cos(radians)));
+Rotation Rotation::inverse() const {
+    return Rotation(this->cos, -this->sin);
+}
 
+Rotation Rotation::operator*(Rotation other) const {
+    return Rotation(this->cos * other.cos - this->sin * other.sin, this->sin * other.cos + this->cos * other.sin);
 }
 
-void Shape::rotate(float degrees, vec2 origin) {
+vec2 Rotation::rotate(vec2 vec) const {
+    return vec2((vec.x * this->cos) - (vec.y * this->sin), (vec.x * this->sin) + (vec.y * this->cos));
+}
 
+void rotateVector(vec2& vec, float degrees, vec2 origin) {
+    rotateVector(vec, Rotation(degrees), origin);
 }
 
-void Shape::translate(vec2 by) {
-    
+void rotateVector(vec2& vec, Rotation rotation, vec2 origin) {
+    vec = origin + rotation.rotate(vec - origin);
 }
 
 Line::Line(vec2 start, vec2 end) {
@@ -27,8 +40,12 @@ Line::Line(vec2 start, vec2 end) {
 }
 
 void Line::rotate(float degrees, vec2 origin) {
-    rotateVector(this->start, degrees, origin);
-    rotateVector(this->end, degrees, origin);
+    this->rotate(Rotation(degrees), origin);
+}
+
+void Line::rotate(Rotation rotation, vec2 origin) {
+    rotateVector(this->start, rotation, origin);
+    rotateVector(this->end, rotation, origin);
 }
 
 void Line::translate(vec2 by) {
@@ -43,9 +60,13 @@ Triangle::Triangle(vec2 a, vec2 b, vec2 c) {
 }
 
 void Triangle::rotate(float degrees, vec2 origin) {
-    rotateVector(this->a, degrees, origin);
-    rotateVector(this->b, degrees, origin);
-    rotateVector(this->c, degrees, origin);
+    this->rotate(Rotation(degrees), origin);
+}
+
+void Triangle::rotate(Rotation rotation, vec2 origin) {
+    rotateVector(this->a, rotation, origin);
+    rotateVector(this->b, rotation, origin);
+    rotateVector(this->c, rotation, origin);
 }
 
 void Triangle::translate(vec2 by) {
@@ -54,10 +75,16 @@ void Triangle::translate(vec2 by) {
     this->c += by;
 }
 
-vec2 Triangle::centroid() {
+vec2 Triangle::centroid() const {
     return vec2((this->a.x + this->b.x + this->c.x) / 3.0f, (this->a.y + this->b.y + this->c.y) / 3.0f);
 }
 
+AABB Triangle::getAABB() const {
+    vec2 min = vec2(std::min(std::min(this->a.x, this->b.x), this->c.x), std::min(std::min(this->a.y, this->b.y), this->c.y));
+    vec2 max = vec2(std::max(std::max(this->a.x, this->b.x), this->c.x), std::max(std::max(this->a.y, this->b.y), this->c.y));
+    return {min, max};
+}
+
 Line Triangle::left(vec2 vertex) {
     if (vertex == this->a) {return Line(this->a, this->c);}
     if (vertex == this->b) {return Line(this->b, this->a);}
@@ -72,11 +99,94 @@ Line Triangle::right(vec2 vertex) {
     return Line(vec2(0.0f, 0.0f), vec2(0.0f, 0.0f));
 }
 
+TriangleCache::TriangleCache(const Triangle& triangle) {
+
+    // Store the vertices in counter-clockwise order.
+    vec2 ab = triangle.b - triangle.a;
+    vec2 ac = triangle.c - triangle.a;
+    bool clockwise = ab.x * ac.y - ab.y * ac.x < 0.0f;
+    this->vertices[0] = triangle.a;
+    this->vertices[1] = clockwise ? triangle.c : triangle.b;
+    this->vertices[2] = clockwise ? triangle.b : triangle.c;
+    this->indices[0] = 0;
+    this->indices[1] = clockwise ? 2 : 1;
+    this->indices[2] = clockwise ? 1 : 2;
+
+    // With counter-clockwise winding, the outward normal is the edge turned a quarter clockwise.
+    for (int i = 0; i < 3; i++) {
+        vec2 edge = this->vertices[(i + 1) % 3] - this->vertices[i];
+        this->normals[i] = glm::normalize(vec2(edge.y, -edge.x));
+    }
+
+    this->bounds = triangle.getAABB();
+
+    // The bounding circle reaches the vertex furthest from the centroid.
+    this->centre = triangle.centroid();
+    vec2 da = triangle.a - this->centre;
+    vec2 db = triangle.b - this->centre;
+    vec2 dc = triangle.c - this->centre;
+    this->radius = sqrtf(std::max(std::max(glm::dot(da, da), glm::dot(db, db)), glm::dot(dc, dc)));
+
+}
+
 Circle::Circle(float radius, vec2 centre) {
     this->radius = radius;
     this->centre = centre;
 }
 
+void Circle::rotate(float degrees, vec2 origin) {
+    this->rotate(Rotation(degrees), origin);
+}
+
+void Circle::rotate(Rotation rotation, vec2 origin) {
+    rotateVector(this->centre, rotation, origin);
+}
+
 void Circle::translate(vec2 by) {
     this->centre += by;
+}
+
+AABB Circle::getAABB() const {
+    return {this->centre - this->radius, this->centre + this->radius};
+}
+
+ShapeRef::ShapeRef(Circle* circle) {
+    this->type = ShapeType::CIRCLE;
+    this->shape = circle;
+}
+
+ShapeRef::ShapeRef(Triangle* triangle) {
+    this->type = ShapeType::TRIANGLE;
+    this->shape = triangle;
+}
+
+Circle* ShapeRef::circle() const {
+    return this->type == ShapeType::CIRCLE ? (Circle*) this->shape : nullptr;
+}
+
+Triangle* ShapeRef::triangle() const {
+    return this->type == ShapeType::TRIANGLE ? (Triangle*) this->shape : nullptr;
+}
+
+void ShapeRef::rotate(float degrees, vec2 origin) {
+    this->rotate(Rotation(degrees), origin);
+}
+
+void ShapeRef::rotate(Rotation rotation, vec2 origin) {
+    switch (this->type) {
+        case ShapeType::CIRCLE: ((Circle*) this->shape)->rotate(rotation, origin); break;
+        case ShapeType::TRIANGLE: ((Triangle*) this->shape)->rotate(rotation, origin); break;
+    }
+}
+
+void ShapeRef::translate(vec2 by) {
+    switch (this->type) {
+        case ShapeType::CIRCLE: ((Circle*) this->shape)->translate(by); break;
+        case ShapeType::TRIANGLE: ((Triangle*) this->shape)->translate(by); break;
+    }
+}
+
+AABB ShapeRef::getAABB() const {
+    if (this->type == ShapeType::CIRCLE) {return ((Circle*) this->shape)->getAABB();}
+    return ((Triangle*) this->shape)->getAABB();
 }
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include <cmath>
+#include <algorithm>
+#include "quadtree.hpp"
+
+namespace {
+
+    const int NONE = -1;
+    const int MAX_DEPTH = 10;
+    const int STACK_SIZE = 64;
+
+    struct Cell {
+        int level;
+        int x;
+        int y;
+    };
+
+    bool contains(AABB outer, AABB inner) {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+    }
+
+}
+
+LooseQuadtree::LooseQuadtree(vec2 min, vec2 max, int depth) {
+
+    this->origin = min;
+    this->size = std::max(max.x - min.x, max.y - min.y);
+    this->depth = std::min(std::max(depth, 0), MAX_DEPTH);
+
+    // Level l holds 4^l nodes, stored after every shallower level.
+    int total = 0;
+    for (int level = 0; level <= this->depth; level++) {
+        this->offsets.push_back(total);
+        total += 1 << (2 * level);
+    }
+
+    this->heads.assign(total, NONE);
+    this->counts.assign(total, 0);
+
+}
+
+int LooseQuadtree::getNode(AABB aabb) const {
+
+    // Start at the deepest level whose cells are at least as large as the proxy.
+    vec2 extent = aabb.max - aabb.min;
+    float largest = std::max(extent.x, extent.y);
+    int level = this->depth;
+    if (largest > 0.0f) {level = std::min(level, (int) floorf(log2f(this->size / largest)));}
+
+    vec2 centre = (aabb.min + aabb.max) * 0.5f;
+
+    // Rounding, or a centre outside the region, can leave the proxy outside the loose bounds.
+    for (; level > 0; level--) {
+
+        int cells = 1 << level;
+        float cell = this->size / cells;
+        int x = (int) floorf((centre.x - this->origin.x) / cell);
+        int y = (int) floorf((centre.y - this->origin.y) / cell);
+        if (x < 0 || y < 0 || x >= cells || y >= cells) {continue;}
+
+        vec2 min = this->origin + vec2(x - 0.5f, y - 0.5f) * cell;
+        vec2 max = this->origin + vec2(x + 1.5f, y + 1.5f) * cell;
+        if (contains({min, max}, aabb)) {return this->offsets[level] + y * cells + x;}
+
+    }
+
+    return 0;
+
+}
+
+bool LooseQuadtree::fits(int node, AABB aabb) const {
+
+    int level = this->depth;
+    while (this->offsets[level] > node) {level--;}
+    int cells = 1 << level;
+    float cell = this->size / cells;
+
+    // A proxy no larger than half a cell belongs on a deeper level.
+    vec2 extent = aabb.max - aabb.min;
+    if (level < this->depth && 2.0f * std::max(extent.x, extent.y) <= cell) {return false;}
+    if (level == 0) {return true;}
+
+    int index = node - this->offsets[level];
+    int x = index % cells;
+    int y = index / cells;
+    vec2 min = this->origin + vec2(x - 0.5f, y - 0.5f) * cell;
+    vec2 max = this->origin + vec2(x + 1.5f, y + 1.5f) * cell;
+    return contains({min, max}, aabb);
+
+}
+
+void LooseQuadtree::link(int id, int node) {
+
+    Proxy& proxy = this->proxies[id];
+    proxy.node = node;
+    proxy.previous = NONE;
+    proxy.next = this->heads[node];
+    if (proxy.next != NONE) {this->proxies[proxy.next].previous = id;}
+    this->heads[node] = id;
+
+    // Count the proxy in every node on the way to the root.
+    int level = this->depth;
+    while (this->offsets[level] > node) {level--;}
+    int index = node - this->offsets[level];
+    int x = index % (1 << level);
+    int y = index / (1 << level);
+
+    for (; level >= 0; level--, x /= 2, y /= 2) {
+        this->counts[this->offsets[level] + y * (1 << level) + x]++;
+    }
+
+}
+
+void LooseQuadtree::unlink(int id) {
+
+    Proxy& proxy = this->proxies[id];
+    int node = proxy.node;
+    if (proxy.previous != NONE) {this->proxies[proxy.previous].next = proxy.next;}
+    else {this->heads[node] = proxy.next;}
+    if (proxy.next != NONE) {this->proxies[proxy.next].previous = proxy.previous;}
+    proxy.node = NONE;
+
+    int level = this->depth;
+    while (this->offsets[level] > node) {level--;}
+    int index = node - this->offsets[level];
+    int x = index % (1 << level);
+    int y = index / (1 << level);
+
+    for (; level >= 0; level--, x /= 2, y /= 2) {
+        this->counts[this->offsets[level] + y * (1 << level) + x]--;
+    }
+
+}
+
+void LooseQuadtree::insert(int id, AABB aabb) {
+
+    if (id >= (int) this->proxies.size()) {this->proxies.resize(id + 1, {{}, NONE, NONE, NONE});}
+    if (this->proxies[id].node != NONE) {
+        this->update(id, aabb);
+        return;
+    }
+
+    this->proxies[id].aabb = aabb;
+    this->link(id, this->getNode(aabb));
+
+}
+
+void LooseQuadtree::update(int id, AABB aabb) {
+
+    this->proxies[id].aabb = aabb;
+
+    // Stay in the current node while it still holds the proxy, even if the centre has left its cell.
+    if (this->fits(this->proxies[id].node, aabb)) {return;}
+
+    int node = this->getNode(aabb);
+    if (node == this->proxies[id].node) {return;}
+
+    this->unlink(id);
+    this->link(id, node);
+
+}
+
+void LooseQuadtree::remove(int id) {
+    if (id < 0 || id >= (int) this->proxies.size() || this->proxies[id].node == NONE) {return;}
+    this->unlink(id);
+}
+
+void LooseQuadtree::search(AABB region, int level, std::vector<int>& result) const {
+
+    Cell stack[STACK_SIZE];
+    int size = 0;
+
+    // Start from every node on the level whose loose bounds overlap the region.
+    int side = 1 << level;
+    float width = this->size / side;
+    int x0 = std::max((int) ceilf((region.min.x - this->origin.x) / width - 1.5f), 0);
+    int y0 = std::max((int) ceilf((region.min.y - this->origin.y) / width - 1.5f), 0);
+    int x1 = std::min((int) floorf((region.max.x - this->origin.x) / width + 0.5f), side - 1);
+    int y1 = std::min((int) floorf((region.max.y - this->origin.y) / width + 0.5f), side - 1);
+    if (level == 0) {x0 = y0 = x1 = y1 = 0;}
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            stack[size++] = {level, x, y};
+        }
+    }
+
+    while (size > 0) {
+
+        Cell current = stack[--size];
+        int cells = 1 << current.level;
+        int node = this->offsets[current.level] + current.y * cells + current.x;
+        if (this->counts[node] == 0) {continue;}
+
+        // The root is unbounded, every other node reaches half a cell past its cell.
+        if (current.level > 0) {
+            float cell = this->size / cells;
+            vec2 min = this->origin + vec2(current.x - 0.5f, current.y - 0.5f) * cell;
+            vec2 max = this->origin + vec2(current.x + 1.5f, current.y + 1.5f) * cell;
+            if (!overlaps({min, max}, region)) {continue;}
+        }
+
+        for (int id = this->heads[node]; id != NONE; id = this->proxies[id].next) {
+            if (overlaps(this->proxies[id].aabb, region)) {result.push_back(id);}
+        }
+
+        if (current.level == this->depth) {continue;}
+
+        for (int child = 0; child < 4; child++) {
+            stack[size++] = {current.level + 1, current.x * 2 + (child & 1), current.y * 2 + (child >> 1)};
+        }
+
+    }
+
+}
+
+void LooseQuadtree::query(AABB region, std::vector<int>& result) {
+    this->search(region, 0, result);
+}
+
+void LooseQuadtree::getPairs(std::vector<Pair>& pairs) {
+
+    pairs.clear();
+
+    // Each proxy searches its own level and below, as the proxies above it will find it themselves.
+    // Pairs on the same level are kept by the proxy with the lower id, so each is found once.
+    for (int level = 0; level <= this->depth; level++) {
+
+        int deeper = level < this->depth ? this->offsets[level + 1] : (int) this->heads.size();
+
+        for (int node = this->offsets[level]; node < deeper; node++) {
+            for (int id = this->heads[node]; id != NONE; id = this->proxies[id].next) {
+
+                this->found.clear();
+                this->search(this->proxies[id].aabb, level, this->found);
+
+                for (int other : this->found) {
+                    if (other == id) {continue;}
+                    if (this->proxies[other].node >= deeper || other > id) {pairs.push_back({std::min(id, other), std::max(id, other)});}
+                }
+
+            }
+        }
+
+    }
+
+}
@@ -0,0 +1,305 @@
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/geometric.hpp>
+#include "collision.hpp"
+#include "simd.hpp"
+
+#ifdef TRIP2D_LANES
+
+namespace {
+
+    using namespace Simd;
+
+    struct Contacts {
+        floats colliding;
+        floats normalX;
+        floats normalY;
+        floats pointX;
+        floats pointY;
+        floats depth;
+        floats feature;
+    };
+
+    // Takes the contact from first in every lane where it collides, and from second everywhere else.
+    Contacts prefer(const Contacts& first, const Contacts& second) {
+        Contacts result;
+        result.colliding = either(first.colliding, second.colliding);
+        result.normalX = select(first.colliding, first.normalX, second.normalX);
+        result.normalY = select(first.colliding, first.normalY, second.normalY);
+        result.pointX = select(first.colliding, first.pointX, second.pointX);
+        result.pointY = select(first.colliding, first.pointY, second.pointY);
+        result.depth = select(first.colliding, first.depth, second.depth);
+        result.feature = select(first.colliding, first.feature, second.feature);
+        return result;
+    }
+
+    // Appends the colliding lanes of a block starting at offset, and returns the new count.
+    int emit(const Contacts& contacts, int offset, CollisionResult* results, int* indices, int count) {
+
+        int mask = bits(contacts.colliding);
+        if (mask == 0) {return count;}
+
+        float normalX[TRIP2D_LANES];
+        float normalY[TRIP2D_LANES];
+        float pointX[TRIP2D_LANES];
+        float pointY[TRIP2D_LANES];
+        float depth[TRIP2D_LANES];
+        float feature[TRIP2D_LANES];
+        store(normalX, contacts.normalX);
+        store(normalY, contacts.normalY);
+        store(pointX, contacts.pointX);
+        store(pointY, contacts.pointY);
+        store(depth, contacts.depth);
+        store(feature, contacts.feature);
+
+        for (int i = 0; i < TRIP2D_LANES; i++) {
+            if ((mask & (1 << i)) == 0) {continue;}
+            results[count] = {true, vec2(normalX[i], normalY[i]), vec2(pointX[i], pointY[i]), depth[i], (unsigned int) feature[i]};
+            indices[count] = offset + i;
+            count++;
+        }
+
+        return count;
+
+    }
+
+    // Mirrors getCollision(Circle c, vec2 p) in src/collision.cpp, one circle per lane.
+    // Features are small integers, so they travel through the lanes exactly as floats.
+    Contacts collideCorner(floats x, floats y, floats radius, vec2 p, unsigned int feature) {
+
+        floats differenceX = sub(x, splat(p.x));
+        floats differenceY = sub(y, splat(p.y));
+        floats distance2 = add(mul(differenceX, differenceX), mul(differenceY, differenceY));
+
+        floats inverse = div(splat(1.0f), sqrt(distance2));
+        floats normalX = mul(differenceX, inverse);
+        floats normalY = mul(differenceY, inverse);
+
+        floats depthX = mul(sub(mul(normalX, radius), differenceX), splat(0.5f));
+        floats depthY = mul(sub(mul(normalY, radius), differenceY), splat(0.5f));
+
+        Contacts result;
+        result.colliding = less(distance2, mul(radius, radius));
+        result.normalX = normalX;
+        result.normalY = normalY;
+        result.pointX = sub(splat(p.x), depthX);
+        result.pointY = sub(splat(p.y), depthY);
+        result.depth = sqrt(add(mul(depthX, depthX), mul(depthY, depthY)));
+        result.feature = splat((float) feature);
+        return result;
+
+    }
+
+    // Mirrors getCollision(Circle c, vec2 start, vec2 end) in src/collision.cpp, one circle per lane.
+    // Everything that depends only on the edge is computed once, exactly as the scalar path does.
+    Contacts collideEdge(floats x, floats y, floats radius, vec2 start, vec2 end, unsigned int feature) {
+
+        end -= start;
+        vec2 direction = glm::normalize(end);
+        Rotation rotation = Rotation(direction.x, -direction.y);
+        Rotation inverse = rotation.inverse();
+        float length = rotation.rotate(end).x;
+        vec2 normal = inverse.rotate(vec2(0.0f, 1.0f));
+
+        // Rotate the circle centres into the space of the edge.
+        floats localX = sub(x, splat(start.x));
+        floats localY = sub(y, splat(start.y));
+        floats alongX = sub(mul(localX, splat(rotation.cos)), mul(localY, splat(rotation.sin)));
+        floats alongY = add(mul(localX, splat(rotation.sin)), mul(localY, splat(rotation.cos)));
+
+        // The centre must be above the edge by less than the radius, and within its x range.
+        floats colliding = both(lessEqual(splat(0.0f), alongY), less(alongY, radius));
+        colliding = both(colliding, both(lessEqual(splat(0.0f), alongX), lessEqual(alongX, splat(length))));
+
+        floats depth = mul(sub(radius, alongY), splat(0.5f));
+        floats below = sub(splat(0.0f), depth);
+
+        Contacts result;
+        result.colliding = colliding;
+        result.normalX = splat(normal.x);
+        result.normalY = splat(normal.y);
+        result.pointX = add(sub(mul(alongX, splat(inverse.cos)), mul(below, splat(inverse.sin))), splat(start.x));
+        result.pointY = add(add(mul(alongX, splat(inverse.sin)), mul(below, splat(inverse.cos))), splat(start.y));
+        result.depth = depth;
+        result.feature = splat((float) feature);
+        return result;
+
+    }
+
+    // Mirrors the test for a centre inside the triangle in getCollision(Circle, const TriangleCache&)
+    // in src/collision.cpp, one circle per lane.
+    Contacts collideInside(floats x, floats y, floats radius, const TriangleCache& t) {
+
+        // Find the edge each centre lies furthest outside of, which is the nearest edge for a centre inside.
+        floats distance;
+        floats normalX;
+        floats normalY;
+        floats feature;
+
+        for (int i = 0; i < 3; i++) {
+
+            vec2 v = t.vertices[i];
+            vec2 n = t.normals[i];
+            floats d = add(mul(sub(x, splat(v.x)), splat(n.x)), mul(sub(y, splat(v.y)), splat(n.y)));
+            float f = (float) ((FEATURE_EDGE | t.indices[(i + 2) % 3]) << 8);
+
+            if (i == 0) {
+                distance = d;
+                normalX = splat(n.x);
+                normalY = splat(n.y);
+                feature = splat(f);
+                continue;
+            }
+
+            floats further = less(distance, d);
+            distance = select(further, d, distance);
+            normalX = select(further, splat(n.x), normalX);
+            normalY = select(further, splat(n.y), normalY);
+            feature = select(further, splat(f), feature);
+
+        }
+
+        floats depth = mul(sub(radius, distance), splat(0.5f));
+        floats offset = add(distance, depth);
+
+        Contacts result;
+        result.colliding = less(distance, splat(0.0f));
+        result.normalX = normalX;
+        result.normalY = normalY;
+        result.pointX = sub(x, mul(normalX, offset));
+        result.pointY = sub(y, mul(normalY, offset));
+        result.depth = depth;
+        result.feature = feature;
+        return result;
+
+    }
+
+}
+
+int getCollisions(const float* x, const float* y, const float* radii, int n, Circle c, CollisionResult* results, int* indices) {
+
+    int count = 0;
+    int i = 0;
+
+    for (; i + TRIP2D_LANES <= n; i += TRIP2D_LANES) {
+
+        floats centreX = load(x + i);
+        floats centreY = load(y + i);
+        floats radius = load(radii + i);
+
+        // Determine which circles are colliding.
+        floats sumRadii = add(radius, splat(c.radius));
+        floats distanceX = sub(centreX, splat(c.centre.x));
+        floats distanceY = sub(centreY, splat(c.centre.y));
+        floats distance2 = add(mul(distanceX, distanceX), mul(distanceY, distanceY));
+
+        Contacts contacts;
+        contacts.colliding = lessEqual(sub(distance2, mul(sumRadii, sumRadii)), splat(0.0f));
+        if (bits(contacts.colliding) == 0) {continue;}
+
+        // Find the depth, normal and contact point of each collision.
+        floats length = sqrt(distance2);
+        floats inverse = div(splat(1.0f), length);
+        contacts.depth = mul(abs(sub(length, sumRadii)), splat(0.5f));
+        contacts.normalX = mul(distanceX, inverse);
+        contacts.normalY = mul(distanceY, inverse);
+
+        floats distanceToPoint = sub(radius, contacts.depth);
+        contacts.pointX = add(mul(distanceToPoint, sub(splat(0.0f), contacts.normalX)), centreX);
+        contacts.pointY = add(mul(distanceToPoint, sub(splat(0.0f), contacts.normalY)), centreY);
+        contacts.feature = splat(0.0f);
+
+        count = emit(contacts, i, results, indices, count);
+
+    }
+
+    // Finish the remainder with the scalar kernel.
+    for (; i < n; i++) {
+        CollisionResult result = getCollision(Circle(radii[i], vec2(x[i], y[i])), c);
+        results[count] = result;
+        indices[count] = i;
+        count += result.colliding ? 1 : 0;
+    }
+
+    return count;
+
+}
+
+int getCollisions(const float* x, const float* y, const float* radii, int n, const TriangleCache& cache, CollisionResult* results, int* indices) {
+
+    // Work from the counter-clockwise cached vertices, naming features by their original index.
+    const vec2* v = cache.vertices;
+    const int* k = cache.indices;
+    vec2 min = cache.bounds.min;
+    vec2 max = cache.bounds.max;
+
+    int count = 0;
+    int i = 0;
+
+    for (; i + TRIP2D_LANES <= n; i += TRIP2D_LANES) {
+
+        floats centreX = load(x + i);
+        floats centreY = load(y + i);
+        floats radius = load(radii + i);
+
+        // Check which circles are in the triangles aabb
+        floats inside = both(lessEqual(sub(splat(min.x), radius), centreX), lessEqual(centreX, add(splat(max.x), radius)));
+        inside = both(inside, both(lessEqual(sub(splat(min.y), radius), centreY), lessEqual(centreY, add(splat(max.y), radius))));
+        if (bits(inside) == 0) {continue;}
+
+        // Evaluate every corner, edge and the inside, then keep the first hit in the same order as the scalar overload.
+        Contacts contacts = collideCorner(centreX, centreY, radius, v[2], (FEATURE_VERTEX | k[2]) << 8);
+        contacts = prefer(collideCorner(centreX, centreY, radius, v[1], (FEATURE_VERTEX | k[1]) << 8), contacts);
+        contacts = prefer(collideCorner(centreX, centreY, radius, v[0], (FEATURE_VERTEX | k[0]) << 8), contacts);
+        contacts = prefer(collideEdge(centreX, centreY, radius, v[1], v[0], (FEATURE_EDGE | k[2]) << 8), contacts);
+        contacts = prefer(collideEdge(centreX, centreY, radius, v[2], v[1], (FEATURE_EDGE | k[0]) << 8), contacts);
+        contacts = prefer(collideEdge(centreX, centreY, radius, v[0], v[2], (FEATURE_EDGE | k[1]) << 8), contacts);
+        contacts = prefer(collideInside(centreX, centreY, radius, cache), contacts);
+        contacts.colliding = both(contacts.colliding, inside);
+
+        count = emit(contacts, i, results, indices, count);
+
+    }
+
+    // Finish the remainder with the scalar kernel.
+    for (; i < n; i++) {
+        CollisionResult result = getCollision(Circle(radii[i], vec2(x[i], y[i])), cache);
+        results[count] = result;
+        indices[count] = i;
+        count += result.colliding ? 1 : 0;
+    }
+
+    return count;
+
+}
+
+#else
+
+int getCollisions(const float* x, const float* y, const float* radii, int n, Circle c, CollisionResult* results, int* indices) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        CollisionResult result = getCollision(Circle(radii[i], vec2(x[i], y[i])), c);
+        results[count] = result;
+        indices[count] = i;
+        count += result.colliding ? 1 : 0;
+    }
+    return count;
+}
+
+int getCollisions(const float* x, const float* y, const float* radii, int n, const TriangleCache& t, CollisionResult* results, int* indices) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        CollisionResult result = getCollision(Circle(radii[i], vec2(x[i], y[i])), t);
+        results[count] = result;
+        indices[count] = i;
+        count += result.colliding ? 1 : 0;
+    }
+    return count;
+}
+
+#endif
+
+int getCollisions(const float* x, const float* y, const float* radii, int n, const Triangle& t, CollisionResult* results, int* indices) {
+    return getCollisions(x, y, radii, n, TriangleCache(t), results, indices);
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include "sweep.hpp"
+
+namespace {
+
+    bool isMax(int data) {
+        return (data & 1) != 0;
+    }
+
+    // Mins sort before maxes of equal value, so touching AABBs count as overlapping.
+    bool before(float value, int data, float otherValue, int otherData) {
+        if (value != otherValue) {return value < otherValue;}
+        return !isMax(data) && isMax(otherData);
+    }
+
+}
+
+void SweepAndPrune::insert(int id, AABB aabb) {
+
+    if (this->proxies.contains(id)) {
+        this->update(id, aabb);
+        return;
+    }
+
+    // New endpoints start at the end of the lists, and are sorted into place on the next step.
+    this->proxies.insert(id, aabb);
+    for (int axis = 0; axis < 2; axis++) {
+        this->endpoints[axis].push_back({aabb.min[axis], id << 1});
+        this->endpoints[axis].push_back({aabb.max[axis], (id << 1) | 1});
+    }
+
+}
+
+void SweepAndPrune::update(int id, AABB aabb) {
+    this->proxies.update(id, aabb);
+}
+
+void SweepAndPrune::remove(int id) {
+
+    if (!this->proxies.contains(id)) {return;}
+    this->proxies.remove(id);
+
+    for (int axis = 0; axis < 2; axis++) {
+        std::vector<Endpoint>& list = this->endpoints[axis];
+        list.erase(std::remove_if(list.begin(), list.end(), [id](const Endpoint& e) {return (e.data >> 1) == id;}), list.end());
+    }
+
+    // Iterate backwards, as removing a pair swaps the last pair into its place.
+    for (int i = (int) this->manager.pairs.size() - 1; i >= 0; i--) {
+        Pair pair = this->manager.pairs[i];
+        if (pair.a == id || pair.b == id) {this->manager.remove(pair.a, pair.b);}
+    }
+
+}
+
+void SweepAndPrune::sort(int axis) {
+
+    std::vector<Endpoint>& list = this->endpoints[axis];
+
+    // Refresh the endpoint values from the latest AABBs.
+    for (Endpoint& endpoint : list) {
+        AABB aabb = this->proxies.getAABB(endpoint.data >> 1);
+        endpoint.value = isMax(endpoint.data) ? aabb.max[axis] : aabb.min[axis];
+    }
+
+    for (int i = 1; i < (int) list.size(); i++) {
+
+        Endpoint endpoint = list[i];
+        int j = i;
+
+        while (j > 0 && before(endpoint.value, endpoint.data, list[j - 1].value, list[j - 1].data)) {
+
+            Endpoint other = list[j - 1];
+            int a = endpoint.data >> 1;
+            int b = other.data >> 1;
+
+            // A min moving below a max may start an overlap, and a max moving below a min ends one.
+            if (!isMax(endpoint.data) && isMax(other.data)) {
+                if (overlaps(this->proxies.getAABB(a), this->proxies.getAABB(b))) {this->manager.add(a, b);}
+            }
+
+            else if (isMax(endpoint.data) && !isMax(other.data)) {
+                this->manager.remove(a, b);
+            }
+
+            list[j] = other;
+            j--;
+
+        }
+
+        list[j] = endpoint;
+
+    }
+
+}
+
+void SweepAndPrune::updatePairs(std::vector<Pair>& begun, std::vector<Pair>& ended) {
+
+    this->sort(0);
+    this->sort(1);
+
+    begun.assign(this->manager.begun.begin(), this->manager.begun.end());
+    ended.assign(this->manager.ended.begin(), this->manager.ended.end());
+    this->manager.clearEvents();
+
+}
+
+void SweepAndPrune::query(AABB region, std::vector<int>& result) {
+
+    this->sort(0);
+    this->sort(1);
+
+    // Every AABB that overlaps the region starts before the region ends on the x axis.
+    for (const Endpoint& endpoint : this->endpoints[0]) {
+        if (endpoint.value > region.max.x) {break;}
+        if (isMax(endpoint.data)) {continue;}
+        int id = endpoint.data >> 1;
+        if (overlaps(this->proxies.getAABB(id), region)) {result.push_back(id);}
+    }
+
+}
+
+void SweepAndPrune::getPairs(std::vector<Pair>& pairs) {
+
+    this->sort(0);
+    this->sort(1);
+    this->manager.clearEvents();
+
+    pairs.assign(this->manager.pairs.begin(), this->manager.pairs.end());
+
+}
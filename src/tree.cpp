@@ -0,0 +1,388 @@
+#include <algorithm>
+#include "tree.hpp"
+
+namespace {
+
+    const int NONE = -1;
+
+    AABB combine(AABB a, AABB b) {
+        return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+    }
+
+    float perimeter(AABB a) {
+        vec2 size = a.max - a.min;
+        return 2.0f * (size.x + size.y);
+    }
+
+    bool contains(AABB outer, AABB inner) {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+    }
+
+}
+
+DynamicTree::DynamicTree(float margin) {
+    this->margin = margin;
+    this->root = NONE;
+    this->freeList = NONE;
+}
+
+void DynamicTree::insert(int id, AABB aabb) {
+
+    if (this->proxies.contains(id)) {
+        this->update(id, aabb);
+        return;
+    }
+
+    this->proxies.insert(id, aabb);
+    if (id >= (int) this->leaves.size()) {this->leaves.resize(id + 1, NONE);}
+
+    int leaf = this->allocate();
+    this->nodes[leaf].aabb = {aabb.min - this->margin, aabb.max + this->margin};
+    this->nodes[leaf].height = 0;
+    this->nodes[leaf].id = id;
+    this->leaves[id] = leaf;
+    this->insertLeaf(leaf);
+
+}
+
+void DynamicTree::update(int id, AABB aabb) {
+
+    this->proxies.update(id, aabb);
+
+    // Small motions stay inside the fat AABB, and need no change to the tree.
+    int leaf = this->leaves[id];
+    if (contains(this->nodes[leaf].aabb, aabb)) {return;}
+
+    this->removeLeaf(leaf);
+    this->nodes[leaf].aabb = {aabb.min - this->margin, aabb.max + this->margin};
+    this->insertLeaf(leaf);
+
+}
+
+void DynamicTree::remove(int id) {
+
+    if (!this->proxies.contains(id)) {return;}
+
+    int leaf = this->leaves[id];
+    this->removeLeaf(leaf);
+    this->release(leaf);
+    this->leaves[id] = NONE;
+    this->proxies.remove(id);
+
+}
+
+void DynamicTree::query(AABB region, std::vector<int>& result) {
+
+    if (this->root == NONE) {return;}
+
+    this->stack.clear();
+    this->stack.push_back(this->root);
+
+    while (!this->stack.empty()) {
+
+        int index = this->stack.back();
+        this->stack.pop_back();
+
+        const Node& node = this->nodes[index];
+        if (!overlaps(node.aabb, region)) {continue;}
+
+        if (node.height > 0) {
+            this->stack.push_back(node.left);
+            this->stack.push_back(node.right);
+            continue;
+        }
+
+        // Leaves are tested against their exact AABB, not the fat one.
+        if (overlaps(this->proxies.getAABB(node.id), region)) {result.push_back(node.id);}
+
+    }
+
+}
+
+void DynamicTree::getPairs(std::vector<Pair>& pairs) {
+
+    pairs.clear();
+    if (this->root == NONE) {return;}
+
+    // Descend the tree against itself. A node paired with itself stands for the pairs within its subtree.
+    this->nodePairs.clear();
+    this->nodePairs.push_back({this->root, this->root});
+
+    while (!this->nodePairs.empty()) {
+
+        Pair current = this->nodePairs.back();
+        this->nodePairs.pop_back();
+
+        const Node& a = this->nodes[current.a];
+        const Node& b = this->nodes[current.b];
+
+        if (current.a == current.b) {
+            if (a.height == 0) {continue;}
+            this->nodePairs.push_back({a.left, a.left});
+            this->nodePairs.push_back({a.right, a.right});
+            this->nodePairs.push_back({a.left, a.right});
+            continue;
+        }
+
+        if (!overlaps(a.aabb, b.aabb)) {continue;}
+
+        // Two leaves are tested against their exact AABBs.
+        if (a.height == 0 && b.height == 0) {
+            if (overlaps(this->proxies.getAABB(a.id), this->proxies.getAABB(b.id))) {
+                pairs.push_back({std::min(a.id, b.id), std::max(a.id, b.id)});
+            }
+            continue;
+        }
+
+        // Otherwise split the taller node.
+        if (b.height == 0 || (a.height > 0 && a.height >= b.height)) {
+            this->nodePairs.push_back({a.left, current.b});
+            this->nodePairs.push_back({a.right, current.b});
+        }
+
+        else {
+            this->nodePairs.push_back({current.a, b.left});
+            this->nodePairs.push_back({current.a, b.right});
+        }
+
+    }
+
+}
+
+int DynamicTree::getHeight() const {
+    if (this->root == NONE) {return 0;}
+    return this->nodes[this->root].height;
+}
+
+int DynamicTree::allocate() {
+
+    if (this->freeList == NONE) {
+        this->nodes.push_back(Node());
+        this->freeList = this->nodes.size() - 1;
+        this->nodes[this->freeList].parent = NONE;
+    }
+
+    // Free nodes are linked through their parent index.
+    int index = this->freeList;
+    this->freeList = this->nodes[index].parent;
+
+    Node& node = this->nodes[index];
+    node.parent = NONE;
+    node.left = NONE;
+    node.right = NONE;
+    node.height = 0;
+    node.id = NONE;
+    return index;
+
+}
+
+void DynamicTree::release(int index) {
+    this->nodes[index].parent = this->freeList;
+    this->nodes[index].height = -1;
+    this->freeList = index;
+}
+
+void DynamicTree::insertLeaf(int leaf) {
+
+    if (this->root == NONE) {
+        this->root = leaf;
+        this->nodes[leaf].parent = NONE;
+        return;
+    }
+
+    // Descend to the sibling that grows the total perimeter the least.
+    AABB aabb = this->nodes[leaf].aabb;
+    int index = this->root;
+
+    while (this->nodes[index].height > 0) {
+
+        const Node& node = this->nodes[index];
+        float area = perimeter(node.aabb);
+        float combined = perimeter(combine(node.aabb, aabb));
+
+        // Cost of making a new parent for this node and the leaf, and the cost pushed down to the children.
+        float cost = 2.0f * combined;
+        float inheritance = 2.0f * (combined - area);
+
+        const Node& left = this->nodes[node.left];
+        float leftCost = perimeter(combine(aabb, left.aabb)) + inheritance;
+        if (left.height > 0) {leftCost -= perimeter(left.aabb);}
+
+        const Node& right = this->nodes[node.right];
+        float rightCost = perimeter(combine(aabb, right.aabb)) + inheritance;
+        if (right.height > 0) {rightCost -= perimeter(right.aabb);}
+
+        if (cost < leftCost && cost < rightCost) {break;}
+        index = leftCost < rightCost ? node.left : node.right;
+
+    }
+
+    // Make a new parent for the sibling and the leaf.
+    int sibling = index;
+    int oldParent = this->nodes[sibling].parent;
+    int newParent = this->allocate();
+
+    Node& parent = this->nodes[newParent];
+    parent.parent = oldParent;
+    parent.aabb = combine(aabb, this->nodes[sibling].aabb);
+    parent.height = this->nodes[sibling].height + 1;
+    parent.left = sibling;
+    parent.right = leaf;
+
+    if (oldParent == NONE) {this->root = newParent;}
+    else if (this->nodes[oldParent].left == sibling) {this->nodes[oldParent].left = newParent;}
+    else {this->nodes[oldParent].right = newParent;}
+
+    this->nodes[sibling].parent = newParent;
+    this->nodes[leaf].parent = newParent;
+
+    this->refit(newParent);
+
+}
+
+void DynamicTree::removeLeaf(int leaf) {
+
+    if (leaf == this->root) {
+        this->root = NONE;
+        return;
+    }
+
+    int parent = this->nodes[leaf].parent;
+    int grandParent = this->nodes[parent].parent;
+    int sibling = this->nodes[parent].left == leaf ? this->nodes[parent].right : this->nodes[parent].left;
+
+    // Replace the parent with the sibling.
+    this->nodes[sibling].parent = grandParent;
+    this->release(parent);
+
+    if (grandParent == NONE) {
+        this->root = sibling;
+        return;
+    }
+
+    if (this->nodes[grandParent].left == parent) {this->nodes[grandParent].left = sibling;}
+    else {this->nodes[grandParent].right = sibling;}
+
+    this->refit(grandParent);
+
+}
+
+// Walks from the node to the root, rebalancing and recomputing heights and AABBs.
+void DynamicTree::refit(int index) {
+
+    while (index != NONE) {
+
+        index = this->balance(index);
+
+        Node& node = this->nodes[index];
+        const Node& left = this->nodes[node.left];
+        const Node& right = this->nodes[node.right];
+        node.height = 1 + std::max(left.height, right.height);
+        node.aabb = combine(left.aabb, right.aabb);
+
+        index = node.parent;
+
+    }
+
+}
+
+/*
+Rotates the taller child of A up into the place of A if the subtrees differ in height by more than one.
+Returns the index of the node that now holds the place of A.
+*/
+int DynamicTree::balance(int iA) {
+
+    Node& A = this->nodes[iA];
+    if (A.height < 2) {return iA;}
+
+    int iB = A.left;
+    int iC = A.right;
+    Node& B = this->nodes[iB];
+    Node& C = this->nodes[iC];
+    int difference = C.height - B.height;
+
+    // Rotate C up.
+    if (difference > 1) {
+
+        int iF = C.left;
+        int iG = C.right;
+        Node& F = this->nodes[iF];
+        Node& G = this->nodes[iG];
+
+        C.left = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        if (C.parent == NONE) {this->root = iC;}
+        else if (this->nodes[C.parent].left == iA) {this->nodes[C.parent].left = iC;}
+        else {this->nodes[C.parent].right = iC;}
+
+        // Keep the taller grandchild under C.
+        if (F.height > G.height) {
+            C.right = iF;
+            A.right = iG;
+            G.parent = iA;
+            A.aabb = combine(B.aabb, G.aabb);
+            C.aabb = combine(A.aabb, F.aabb);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+
+        else {
+            C.right = iG;
+            A.right = iF;
+            F.parent = iA;
+            A.aabb = combine(B.aabb, F.aabb);
+            C.aabb = combine(A.aabb, G.aabb);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+
+        return iC;
+
+    }
+
+    // Rotate B up.
+    if (difference < -1) {
+
+        int iD = B.left;
+        int iE = B.right;
+        Node& D = this->nodes[iD];
+        Node& E = this->nodes[iE];
+
+        B.left = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        if (B.parent == NONE) {this->root = iB;}
+        else if (this->nodes[B.parent].left == iA) {this->nodes[B.parent].left = iB;}
+        else {this->nodes[B.parent].right = iB;}
+
+        // Keep the taller grandchild under B.
+        if (D.height > E.height) {
+            B.right = iD;
+            A.left = iE;
+            E.parent = iA;
+            A.aabb = combine(C.aabb, E.aabb);
+            B.aabb = combine(A.aabb, D.aabb);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+
+        else {
+            B.right = iE;
+            A.left = iD;
+            D.parent = iA;
+            A.aabb = combine(C.aabb, D.aabb);
+            B.aabb = combine(A.aabb, E.aabb);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+
+        return iB;
+
+    }
+
+    return iA;
+
+}
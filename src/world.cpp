@@ -0,0 +1,599 @@
+#include <algorithm>
+#include "world.hpp"
+
+namespace {
+
+    const int NONE = -1;
+    const int INDEX_BITS = 22;
+    const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    const uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+    // Pairs per memo job, shapes per batch job and triangle pairs per narrowphase job.
+    const int PAIR_GRAIN = 256;
+    const int BATCH_GRAIN = 64;
+    const int TRIANGLE_GRAIN = 64;
+
+    const CollisionResult SEPARATED = {false, vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), 0.0f, 0};
+
+    // The result of the same pair with its shapes swapped, as getCollision(Triangle, Circle) gives it.
+    CollisionResult flip(CollisionResult result) {
+        result.normal = -result.normal;
+        result.feature = (result.feature & 0xff) << 8 | (result.feature >> 8 & 0xff);
+        return result;
+    }
+
+}
+
+World::World(Broadphase* broadphase) : World(broadphase, nullptr) {}
+
+World::World(Broadphase* broadphase, JobSystem* jobs) {
+    this->broadphase = broadphase;
+    this->jobs = jobs;
+    this->freeList = NONE;
+}
+
+int World::allocate(ShapeType type, int index) {
+
+    int slot = this->freeList;
+
+    if (slot == NONE) {
+        if (this->slots.size() == INDEX_MASK) {return NONE;}
+        slot = this->slots.size();
+        this->slots.push_back({0, type, index, NONE, NONE});
+    }
+
+    else {
+        this->freeList = this->slots[slot].next;
+        this->slots[slot].type = type;
+        this->slots[slot].index = index;
+        this->slots[slot].next = NONE;
+    }
+
+    // New shapes are awake. They have no pairs yet, so there are none to wake.
+    this->slots[slot].awake = this->awake.size();
+    this->awake.push_back(slot);
+    return slot;
+
+}
+
+Handle World::add(Circle circle) {
+
+    int index = this->x.size();
+    int slot = this->allocate(ShapeType::CIRCLE, index);
+    if (slot == NONE) {return INVALID_HANDLE;}
+
+    this->x.push_back(circle.centre.x);
+    this->y.push_back(circle.centre.y);
+    this->radii.push_back(circle.radius);
+    this->circleSlots.push_back(slot);
+
+    this->broadphase->insert(slot, circle.getAABB());
+    return this->getHandle(slot);
+
+}
+
+Handle World::add(const Triangle& triangle) {
+
+    int index = this->ax.size();
+    int slot = this->allocate(ShapeType::TRIANGLE, index);
+    if (slot == NONE) {return INVALID_HANDLE;}
+
+    this->ax.push_back(triangle.a.x);
+    this->ay.push_back(triangle.a.y);
+    this->bx.push_back(triangle.b.x);
+    this->by.push_back(triangle.b.y);
+    this->cx.push_back(triangle.c.x);
+    this->cy.push_back(triangle.c.y);
+    this->caches.push_back(TriangleCache(triangle));
+    this->triangleSlots.push_back(slot);
+
+    this->broadphase->insert(slot, triangle.getAABB());
+    return this->getHandle(slot);
+
+}
+
+void World::remove(Handle handle) {
+
+    if (!this->contains(handle)) {return;}
+
+    // Wake the shape's pairs, so the next collide sees them end.
+    int slot = this->getSlot(handle);
+    this->markPairs(slot, true);
+    if (this->slots[slot].awake != NONE) {this->dropAwake(slot);}
+
+    Slot& removed = this->slots[slot];
+    int index = removed.index;
+
+    // Move the last shape of the pool into the removed index.
+    if (removed.type == ShapeType::CIRCLE) {
+        int last = this->x.size() - 1;
+        this->x[index] = this->x[last];
+        this->y[index] = this->y[last];
+        this->radii[index] = this->radii[last];
+        this->circleSlots[index] = this->circleSlots[last];
+        this->slots[this->circleSlots[index]].index = index;
+        this->x.pop_back();
+        this->y.pop_back();
+        this->radii.pop_back();
+        this->circleSlots.pop_back();
+    }
+
+    else {
+        int last = this->ax.size() - 1;
+        this->ax[index] = this->ax[last];
+        this->ay[index] = this->ay[last];
+        this->bx[index] = this->bx[last];
+        this->by[index] = this->by[last];
+        this->cx[index] = this->cx[last];
+        this->cy[index] = this->cy[last];
+        this->caches[index] = this->caches[last];
+        this->triangleSlots[index] = this->triangleSlots[last];
+        this->slots[this->triangleSlots[index]].index = index;
+        this->ax.pop_back();
+        this->ay.pop_back();
+        this->bx.pop_back();
+        this->by.pop_back();
+        this->cx.pop_back();
+        this->cy.pop_back();
+        this->caches.pop_back();
+        this->triangleSlots.pop_back();
+    }
+
+    removed.index = NONE;
+    this->broadphase->remove(slot);
+
+    // A slot whose generation would wrap around is retired instead of reused, so a handle to a
+    // removed shape can never become valid again.
+    if (removed.generation == GENERATION_MASK) {return;}
+    removed.generation++;
+    this->released.push_back(slot);
+
+}
+
+bool World::contains(Handle handle) const {
+    uint32_t slot = handle & INDEX_MASK;
+    if (slot >= this->slots.size()) {return false;}
+    return this->slots[slot].index != NONE && this->slots[slot].generation == handle >> INDEX_BITS;
+}
+
+ShapeType World::getType(Handle handle) const {
+    return this->slots[this->getSlot(handle)].type;
+}
+
+Circle World::getCircle(Handle handle) const {
+    int index = this->getIndex(handle);
+    return Circle(this->radii[index], vec2(this->x[index], this->y[index]));
+}
+
+Triangle World::getTriangle(Handle handle) const {
+    return this->loadTriangle(this->getIndex(handle));
+}
+
+AABB World::getAABB(Handle handle) const {
+    if (this->getType(handle) == ShapeType::CIRCLE) {return this->getCircle(handle).getAABB();}
+    return this->caches[this->getIndex(handle)].bounds;
+}
+
+Triangle World::loadTriangle(int index) const {
+    return Triangle(vec2(this->ax[index], this->ay[index]), vec2(this->bx[index], this->by[index]), vec2(this->cx[index], this->cy[index]));
+}
+
+void World::storeTriangle(int index, const Triangle& triangle) {
+    this->ax[index] = triangle.a.x;
+    this->ay[index] = triangle.a.y;
+    this->bx[index] = triangle.b.x;
+    this->by[index] = triangle.b.y;
+    this->cx[index] = triangle.c.x;
+    this->cy[index] = triangle.c.y;
+    this->caches[index] = TriangleCache(triangle);
+}
+
+void World::refresh(int slot) {
+    this->broadphase->update(slot, this->getAABB(this->getHandle(slot)));
+}
+
+void World::translate(Handle handle, vec2 by) {
+
+    if (!this->contains(handle)) {return;}
+    this->setAwake(handle, true);
+    int index = this->getIndex(handle);
+
+    if (this->getType(handle) == ShapeType::CIRCLE) {
+        this->x[index] += by.x;
+        this->y[index] += by.y;
+    }
+
+    else {
+        Triangle triangle = this->loadTriangle(index);
+        triangle.translate(by);
+        this->storeTriangle(index, triangle);
+    }
+
+    this->refresh(this->getSlot(handle));
+
+}
+
+void World::rotate(Handle handle, Rotation rotation, vec2 origin) {
+
+    if (!this->contains(handle)) {return;}
+    this->setAwake(handle, true);
+    int index = this->getIndex(handle);
+
+    if (this->getType(handle) == ShapeType::CIRCLE) {
+        vec2 centre = vec2(this->x[index], this->y[index]);
+        rotateVector(centre, rotation, origin);
+        this->x[index] = centre.x;
+        this->y[index] = centre.y;
+    }
+
+    else {
+        Triangle triangle = this->loadTriangle(index);
+        triangle.rotate(rotation, origin);
+        this->storeTriangle(index, triangle);
+    }
+
+    this->refresh(this->getSlot(handle));
+
+}
+
+void World::transform(Handle handle, Rotation rotation, vec2 origin, vec2 by) {
+
+    if (!this->contains(handle)) {return;}
+    this->setAwake(handle, true);
+    int index = this->getIndex(handle);
+
+    if (this->getType(handle) == ShapeType::CIRCLE) {
+        vec2 centre = vec2(this->x[index], this->y[index]);
+        rotateVector(centre, rotation, origin);
+        this->x[index] = centre.x + by.x;
+        this->y[index] = centre.y + by.y;
+    }
+
+    else {
+        Triangle triangle = this->loadTriangle(index);
+        triangle.rotate(rotation, origin);
+        triangle.translate(by);
+        this->storeTriangle(index, triangle);
+    }
+
+    this->refresh(this->getSlot(handle));
+
+}
+
+void World::setAwake(Handle handle, bool awake) {
+
+    if (!this->contains(handle)) {return;}
+    int slot = this->getSlot(handle);
+    if ((this->slots[slot].awake != NONE) == awake) {return;}
+
+    if (awake) {
+        this->slots[slot].awake = this->awake.size();
+        this->awake.push_back(slot);
+    }
+
+    else {
+        this->dropAwake(slot);
+    }
+
+    this->markPairs(slot, awake);
+
+}
+
+bool World::isAwake(Handle handle) const {
+    return this->contains(handle) && this->slots[this->getSlot(handle)].awake != NONE;
+}
+
+int World::getAwakeCount() const {
+    return this->awake.size();
+}
+
+void World::dropAwake(int slot) {
+    int index = this->slots[slot].awake;
+    int last = this->awake.back();
+    this->awake[index] = last;
+    this->slots[last].awake = index;
+    this->awake.pop_back();
+    this->slots[slot].awake = NONE;
+}
+
+void World::markPairs(int slot, bool awake) {
+
+    // The shapes of a sleeping pair have not moved since it was put to sleep, so their AABBs still
+    // overlap and the broadphase finds every one of them.
+    this->found.clear();
+    this->broadphase->query(this->getAABB(this->getHandle(slot)), this->found);
+
+    // Waking a shape wakes all of its pairs, and a shape falling asleep puts to sleep each pair
+    // with another sleeping shape.
+    for (int other : this->found) {
+        int index = other == slot ? NONE : this->pairs.find(slot, other);
+        if (index == NONE) {continue;}
+        if (awake) {this->pairs.wake(index);}
+        else if (this->slots[other].awake == NONE) {this->pairs.sleep(index);}
+    }
+
+}
+
+int World::getSlot(Handle handle) const {
+    return handle & INDEX_MASK;
+}
+
+Handle World::getHandle(int slot) const {
+    return (this->slots[slot].generation << INDEX_BITS) | (uint32_t) slot;
+}
+
+int World::getIndex(Handle handle) const {
+    return this->slots[this->getSlot(handle)].index;
+}
+
+int World::getCircleCount() const {
+    return this->x.size();
+}
+
+const float* World::getCircleX() const {
+    return this->x.data();
+}
+
+const float* World::getCircleY() const {
+    return this->y.data();
+}
+
+const float* World::getCircleRadii() const {
+    return this->radii.data();
+}
+
+Handle World::getCircleHandle(int index) const {
+    return this->getHandle(this->circleSlots[index]);
+}
+
+int World::getTriangleCount() const {
+    return this->ax.size();
+}
+
+const float* World::getTriangleAX() const {
+    return this->ax.data();
+}
+
+const float* World::getTriangleAY() const {
+    return this->ay.data();
+}
+
+const float* World::getTriangleBX() const {
+    return this->bx.data();
+}
+
+const float* World::getTriangleBY() const {
+    return this->by.data();
+}
+
+const float* World::getTriangleCX() const {
+    return this->cx.data();
+}
+
+const float* World::getTriangleCY() const {
+    return this->cy.data();
+}
+
+Handle World::getTriangleHandle(int index) const {
+    return this->getHandle(this->triangleSlots[index]);
+}
+
+void World::collide() {
+    this->collide(0.0f);
+}
+
+void World::collide(float tolerance) {
+
+    // While most shapes are awake, the broadphase finds every pair faster by itself. Otherwise only
+    // the pairs of the awake shapes are looked for, and the sleeping pairs are left as they are.
+    int shapes = this->x.size() + this->ax.size();
+    if (2 * (int) this->awake.size() >= shapes) {
+
+        this->broadphase->getPairs(this->candidates);
+        this->pairs.update(this->candidates);
+
+    }
+
+    else {
+        this->findCandidates();
+        this->pairs.updateAwake(this->candidates);
+    }
+
+    int n = this->pairs.getAwakeCount();
+    this->stale.clear();
+
+    // Keep every result the pair manager can reuse, and list the pairs to run again.
+    if (this->jobs == nullptr) {this->findStale(tolerance, 0, n, this->stale);}
+    else {
+
+        int chunks = (n + PAIR_GRAIN - 1) / PAIR_GRAIN;
+        if ((int) this->buffers.size() < chunks) {this->buffers.resize(chunks);}
+
+        this->jobs->parallelFor(n, PAIR_GRAIN, [this, tolerance](int begin, int end) {
+            std::vector<int>& buffer = this->buffers[begin / PAIR_GRAIN];
+            buffer.clear();
+            this->findStale(tolerance, begin, end, buffer);
+        });
+
+        for (int k = 0; k < chunks; k++) {
+            this->stale.insert(this->stale.end(), this->buffers[k].begin(), this->buffers[k].end());
+        }
+
+    }
+
+    this->sortStale();
+
+    // Every batch and triangle pair writes only its own results. Triangle caches are rebuilt by
+    // add, translate and rotate, so the jobs only read them.
+    int keys = this->keys.size();
+    int triangles = this->trianglePairs.size();
+    if (this->batches.empty()) {this->batches.resize(1);}
+
+    if (this->jobs == nullptr) {
+        for (int k = 0; k < keys; k++) {this->collideBatch(this->keys[k], this->batches[0]);}
+        for (int k = 0; k < triangles; k++) {this->collideTriangles(this->trianglePairs[k]);}
+    }
+
+    else {
+
+        int chunks = (keys + BATCH_GRAIN - 1) / BATCH_GRAIN;
+        if ((int) this->batches.size() < chunks) {this->batches.resize(chunks);}
+
+        this->jobs->parallelFor(keys, BATCH_GRAIN, [this](int begin, int end) {
+            Batch& batch = this->batches[begin / BATCH_GRAIN];
+            for (int k = begin; k < end; k++) {this->collideBatch(this->keys[k], batch);}
+        });
+
+        this->jobs->parallelFor(triangles, TRIANGLE_GRAIN, [this](int begin, int end) {
+            for (int k = begin; k < end; k++) {this->collideTriangles(this->trianglePairs[k]);}
+        });
+
+    }
+
+    for (int slot : this->keys) {this->heads[slot] = NONE;}
+
+    // New pairs between two sleeping shapes, such as static bodies added since the last step, sleep
+    // once they have a result.
+    for (Pair pair : this->pairs.begun) {
+        if (this->slots[pair.a].awake != NONE || this->slots[pair.b].awake != NONE) {continue;}
+        this->pairs.sleep(this->pairs.find(pair.a, pair.b));
+    }
+
+    this->pairs.gather(this->jobs);
+
+    // The pairs of removed shapes have now ended, so their slots can be reused.
+    for (int slot : this->released) {
+        this->slots[slot].next = this->freeList;
+        this->freeList = slot;
+    }
+    this->released.clear();
+
+}
+
+void World::findCandidates() {
+
+    this->candidates.clear();
+
+    // A pair of awake shapes is reported by the one with the lower slot.
+    for (int slot : this->awake) {
+
+        this->found.clear();
+        this->broadphase->query(this->getAABB(this->getHandle(slot)), this->found);
+
+        for (int other : this->found) {
+            if (other == slot) {continue;}
+            if (this->slots[other].awake != NONE && other < slot) {continue;}
+            this->candidates.push_back({std::min(slot, other), std::max(slot, other)});
+        }
+
+    }
+
+}
+
+void World::capture(int slot, vec2* points) const {
+
+    int index = this->slots[slot].index;
+
+    if (this->slots[slot].type == ShapeType::CIRCLE) {
+        vec2 centre = vec2(this->x[index], this->y[index]);
+        points[0] = centre;
+        points[1] = centre + vec2(this->radii[index], 0.0f);
+        points[2] = centre;
+        return;
+    }
+
+    points[0] = vec2(this->ax[index], this->ay[index]);
+    points[1] = vec2(this->bx[index], this->by[index]);
+    points[2] = vec2(this->cx[index], this->cy[index]);
+
+}
+
+void World::findStale(float tolerance, int begin, int end, std::vector<int>& stale) {
+
+    for (int index = begin; index < end; index++) {
+        Pair pair = this->pairs.pairs[index];
+        vec2 points[6];
+        this->capture(pair.a, points);
+        this->capture(pair.b, points + 3);
+        if (!this->pairs.reuse(index, points, tolerance)) {stale.push_back(index);}
+    }
+
+}
+
+void World::sortStale() {
+
+    this->keys.clear();
+    this->trianglePairs.clear();
+    if (this->heads.size() < this->slots.size()) {this->heads.resize(this->slots.size(), NONE);}
+    this->links.resize(this->stale.size());
+
+    // A pair with a circle is batched under its other shape, or under its second shape when both
+    // are circles, so the batched circle is the pair's first shape whenever it can be.
+    for (int k = 0; k < (int) this->stale.size(); k++) {
+
+        Pair pair = this->pairs.pairs[this->stale[k]];
+        bool circleA = this->slots[pair.a].type == ShapeType::CIRCLE;
+        bool circleB = this->slots[pair.b].type == ShapeType::CIRCLE;
+
+        if (!circleA && !circleB) {
+            this->trianglePairs.push_back(this->stale[k]);
+            continue;
+        }
+
+        int key = circleA ? pair.b : pair.a;
+        if (this->heads[key] == NONE) {this->keys.push_back(key);}
+        this->links[k] = this->heads[key];
+        this->heads[key] = k;
+
+    }
+
+}
+
+void World::collideBatch(int key, Batch& batch) {
+
+    batch.x.clear();
+    batch.y.clear();
+    batch.radii.clear();
+    batch.pairs.clear();
+
+    // Gather the circles paired with the key shape into columns of their own.
+    for (int k = this->heads[key]; k != NONE; k = this->links[k]) {
+
+        int index = this->stale[k];
+        Pair pair = this->pairs.pairs[index];
+        int circle = this->slots[pair.a == key ? pair.b : pair.a].index;
+
+        batch.x.push_back(this->x[circle]);
+        batch.y.push_back(this->y[circle]);
+        batch.radii.push_back(this->radii[circle]);
+        batch.pairs.push_back(index);
+        this->pairs.results[index] = SEPARATED;
+
+    }
+
+    int n = batch.pairs.size();
+    batch.results.resize(n);
+    batch.indices.resize(n);
+
+    int count;
+    int index = this->slots[key].index;
+    if (this->slots[key].type == ShapeType::CIRCLE) {
+        Circle circle = Circle(this->radii[index], vec2(this->x[index], this->y[index]));
+        count = getCollisions(batch.x.data(), batch.y.data(), batch.radii.data(), n, circle, batch.results.data(), batch.indices.data());
+    }
+    else {
+        count = getCollisions(batch.x.data(), batch.y.data(), batch.radii.data(), n, this->caches[index], batch.results.data(), batch.indices.data());
+    }
+
+    // The kernels put the batched circle first, so swap the shapes back when the key shape is first.
+    for (int k = 0; k < count; k++) {
+        int pair = batch.pairs[batch.indices[k]];
+        this->pairs.results[pair] = this->pairs.pairs[pair].a == key ? flip(batch.results[k]) : batch.results[k];
+    }
+
+}
+
+void World::collideTriangles(int index) {
+    Pair pair = this->pairs.pairs[index];
+    this->pairs.results[index] = getCollision(this->caches[this->slots[pair.a].index], this->caches[this->slots[pair.b].index]);
+}
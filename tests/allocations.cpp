@@ -0,0 +1,52 @@
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include "allocations.hpp"
+
+namespace {
+
+    std::atomic<long> count(0);
+    std::atomic<bool> counting(false);
+
+}
+
+void allocations::start() {
+    count = 0;
+    counting = true;
+}
+
+long allocations::stop() {
+    counting = false;
+    return count.load();
+}
+
+#ifdef TRIP2D_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {count++;}
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {throw std::bad_alloc();}
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+Test hook counting calls to the global operator new. Linking allocations.cpp into a test built
+with TRIP2D_COUNT_ALLOCATIONS replaces the global allocation functions with counting ones.
+Allocations are only counted between start() and stop().
+*/
+namespace allocations {
+
+    void start();
+
+    // Returns the number of allocations since start().
+    long stop();
+
+}
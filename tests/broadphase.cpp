@@ -0,0 +1,329 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include "grid.hpp"
+#include "tree.hpp"
+#include "sweep.hpp"
+#include "bvh.hpp"
+#include "lbvh.hpp"
+#include "quadtree.hpp"
+#include "hgrid.hpp"
+
+namespace {
+
+    typedef std::set<std::pair<int, int>> PairSet;
+
+    const int PROXIES = 400;
+    const int ROUNDS = 12;
+
+    // Unit boxes on a lattice, which share edges and corners with their neighbours exactly.
+    const int TOUCHING = 9;
+
+    int failures = 0;
+
+    void fail(const char* name, const char* what, int round) {
+        std::printf("failed: %s %s in round %d\n", name, what, round);
+        failures++;
+    }
+
+    /*
+    Proxy AABBs kept alongside a broadphase, as the model it is checked against. Most proxies are
+    small, a few are much larger than the rest, and some lie outside [-16, 16], where the bounded
+    structures clamp them or keep them at the root.
+    */
+    struct Scene {
+
+        std::vector<AABB> boxes;
+        std::vector<bool> live;
+        std::mt19937 rng;
+
+        Scene(unsigned int seed) : boxes(PROXIES), live(PROXIES, false), rng(seed) {}
+
+        AABB randomBox() {
+            std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+            std::uniform_real_distribution<float> extent(0.01f, 1.0f);
+            vec2 centre = vec2(position(this->rng), position(this->rng));
+            float size = extent(this->rng) * (this->rng() % 40 == 0 ? 12.0f : 1.0f);
+            return {centre - size, centre + size};
+        }
+
+        void insert(Broadphase& broadphase) {
+
+            for (int i = 0; i < TOUCHING; i++) {
+                vec2 min = vec2((float) (i % 3), (float) (i / 3));
+                this->boxes[i] = {min, min + vec2(1.0f, 1.0f)};
+            }
+
+            for (int i = TOUCHING; i < PROXIES; i++) {this->boxes[i] = this->randomBox();}
+
+            for (int i = 0; i < PROXIES; i++) {
+                broadphase.insert(i, this->boxes[i]);
+                this->live[i] = true;
+            }
+
+        }
+
+        // Moves most proxies a little and some a long way, removes a few and brings back some of
+        // those removed in earlier rounds. The touching boxes never change.
+        void change(Broadphase& broadphase) {
+
+            std::uniform_real_distribution<float> nudge(-0.3f, 0.3f);
+            std::vector<bool> dead(PROXIES);
+            for (int i = 0; i < PROXIES; i++) {dead[i] = !this->live[i];}
+
+            for (int i = TOUCHING; i < PROXIES; i++) {
+
+                if (!this->live[i]) {continue;}
+
+                int roll = this->rng() % 10;
+                if (roll == 0) {
+                    broadphase.remove(i);
+                    this->live[i] = false;
+                    continue;
+                }
+
+                if (roll == 1) {this->boxes[i] = this->randomBox();}
+                else {
+                    vec2 offset = vec2(nudge(this->rng), nudge(this->rng));
+                    this->boxes[i].min += offset;
+                    this->boxes[i].max += offset;
+                }
+                broadphase.update(i, this->boxes[i]);
+
+            }
+
+            for (int i = TOUCHING; i < PROXIES; i++) {
+                if (!dead[i] || this->rng() % 2 == 0) {continue;}
+                this->boxes[i] = this->randomBox();
+                broadphase.insert(i, this->boxes[i]);
+                this->live[i] = true;
+            }
+
+        }
+
+        PairSet getPairs() const {
+            PairSet pairs;
+            for (int i = 0; i < PROXIES; i++) {
+                for (int j = i + 1; j < PROXIES; j++) {
+                    if (this->live[i] && this->live[j] && overlaps(this->boxes[i], this->boxes[j])) {pairs.insert({i, j});}
+                }
+            }
+            return pairs;
+        }
+
+        std::set<int> query(AABB region) const {
+            std::set<int> ids;
+            for (int i = 0; i < PROXIES; i++) {
+                if (this->live[i] && overlaps(this->boxes[i], region)) {ids.insert(i);}
+            }
+            return ids;
+        }
+
+    };
+
+    // Collects pairs into a set, checking that each is ordered and reported only once.
+    bool collect(const std::vector<Pair>& pairs, PairSet& result) {
+        result.clear();
+        for (Pair pair : pairs) {
+            if (pair.a >= pair.b || !result.insert({pair.a, pair.b}).second) {return false;}
+        }
+        return true;
+    }
+
+    void checkQueries(Broadphase& broadphase, Scene& scene, const char* name, int round) {
+
+        std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> extent(0.0f, 6.0f);
+
+        // A region touching the lattice from the left, then random regions.
+        AABB region = {vec2(-1.0f, 1.0f), vec2(0.0f, 2.0f)};
+
+        for (int i = 0; i < 8; i++) {
+
+            std::vector<int> result;
+            broadphase.query(region, result);
+
+            std::set<int> found(result.begin(), result.end());
+            if (found.size() != result.size()) {fail(name, "query reported a proxy twice", round);}
+            if (found != scene.query(region)) {fail(name, "query disagrees with brute force", round);}
+
+            vec2 centre = vec2(position(scene.rng), position(scene.rng));
+            vec2 size = vec2(extent(scene.rng), extent(scene.rng));
+            region = {centre - size, centre + size};
+
+        }
+
+    }
+
+    /*
+    Drives a broadphase through random inserts, updates and removes, and after each round compares
+    getPairs and query with brute force over the same AABBs.
+    */
+    void checkBroadphase(Broadphase& broadphase, const char* name, unsigned int seed) {
+
+        Scene scene(seed);
+        scene.insert(broadphase);
+
+        // Boxes sharing only an edge or a corner overlap.
+        PairSet touching = scene.getPairs();
+        if (touching.count({0, 1}) == 0 || touching.count({0, 4}) == 0) {fail(name, "brute force missed touching boxes", 0);}
+
+        for (int round = 0; round < ROUNDS; round++) {
+
+            std::vector<Pair> pairs;
+            broadphase.getPairs(pairs);
+
+            PairSet found;
+            if (!collect(pairs, found)) {fail(name, "getPairs reported an unordered or repeated pair", round);}
+            if (found != scene.getPairs()) {fail(name, "getPairs disagrees with brute force", round);}
+
+            checkQueries(broadphase, scene, name, round);
+            scene.change(broadphase);
+
+        }
+
+    }
+
+    /*
+    Runs the same kind of scene through SweepAndPrune::updatePairs. Applying the ended pairs and
+    then the begun pairs to the previous set must give the brute force set, every ended pair must
+    have been overlapping and no begun pair may already have been.
+    */
+    void checkEvents(unsigned int seed) {
+
+        SweepAndPrune sweep;
+        Scene scene(seed);
+        scene.insert(sweep);
+
+        PairSet previous;
+
+        for (int round = 0; round < ROUNDS; round++) {
+
+            std::vector<Pair> begun, ended;
+            sweep.updatePairs(begun, ended);
+
+            PairSet began, stopped;
+            if (!collect(begun, began)) {fail("SweepAndPrune", "reported an unordered or repeated begun pair", round);}
+            if (!collect(ended, stopped)) {fail("SweepAndPrune", "reported an unordered or repeated ended pair", round);}
+
+            PairSet current = previous;
+            for (const std::pair<int, int>& pair : stopped) {
+                if (current.erase(pair) == 0) {fail("SweepAndPrune", "ended a pair that was not overlapping", round);}
+            }
+            for (const std::pair<int, int>& pair : began) {
+                if (!current.insert(pair).second) {fail("SweepAndPrune", "began a pair that was already overlapping", round);}
+            }
+
+            previous = scene.getPairs();
+            if (current != previous) {fail("SweepAndPrune", "events disagree with brute force", round);}
+
+            scene.change(sweep);
+
+        }
+
+    }
+
+    /*
+    StaticBVH is not a Broadphase, as its triangles never move, but its queries must find the same
+    triangles as brute force over their AABBs, and its circle collisions the same hits as getCollision.
+    */
+    void checkStaticBVH(unsigned int seed) {
+
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+        std::vector<Triangle> triangles;
+        for (int i = 0; i < PROXIES; i++) {
+            vec2 centre = vec2(position(rng), position(rng));
+            float size = rng() % 40 == 0 ? 8.0f : 1.0f;
+            triangles.push_back(Triangle(centre + size * vec2(offset(rng), offset(rng)), centre + size * vec2(offset(rng), offset(rng)), centre + size * vec2(offset(rng), offset(rng))));
+        }
+
+        StaticBVH bvh(triangles.data(), triangles.size());
+
+        for (int i = 0; i < 200; i++) {
+
+            // Every tenth region shares its right edge with the left edge of a triangle's AABB.
+            AABB region;
+            if (i % 10 == 0) {
+                AABB bounds = triangles[i].getAABB();
+                region = {bounds.min - vec2(1.0f, 0.0f), vec2(bounds.min.x, bounds.max.y)};
+            }
+            else {
+                vec2 centre = vec2(position(rng), position(rng));
+                region = {centre - 3.0f * vec2(fabsf(offset(rng)), fabsf(offset(rng))), centre + 3.0f * vec2(fabsf(offset(rng)), fabsf(offset(rng)))};
+            }
+
+            std::vector<int> result;
+            bvh.query(region, result);
+
+            std::set<int> found(result.begin(), result.end()), expected;
+            for (int j = 0; j < PROXIES; j++) {
+                if (overlaps(triangles[j].getAABB(), region)) {expected.insert(j);}
+            }
+
+            if (found.size() != result.size()) {fail("StaticBVH", "query reported a triangle twice", i);}
+            if (found != expected) {fail("StaticBVH", "query disagrees with brute force", i);}
+
+            Circle circle = Circle(2.0f * fabsf(offset(rng)), 0.5f * (region.min + region.max));
+            std::vector<CollisionResult> results;
+            std::vector<int> indices;
+            bvh.getCollisions(circle, results, indices);
+
+            found = std::set<int>(indices.begin(), indices.end());
+            expected.clear();
+            for (int j = 0; j < PROXIES; j++) {
+                if (getCollision(circle, triangles[j]).colliding) {expected.insert(j);}
+            }
+
+            if (found.size() != indices.size() || found != expected) {fail("StaticBVH", "circle collisions disagree with brute force", i);}
+
+        }
+
+    }
+
+}
+
+/*
+Checks every broadphase against brute force through the Broadphase interface, over a scene
+with moving, removed and reinserted proxies of mixed sizes and a block of touching boxes,
+and the begin and end events of SweepAndPrune against the change in the brute force pairs.
+StaticBVH is checked on its own, over a fixed set of triangles.
+*/
+int main() {
+
+    Grid bounded(1.0f, vec2(-16.0f, -16.0f), vec2(16.0f, 16.0f));
+    Grid hashed(1.0f, 64);
+    checkBroadphase(bounded, "bounded Grid", 1);
+    checkBroadphase(hashed, "hashed Grid", 2);
+
+    DynamicTree tree(0.1f);
+    checkBroadphase(tree, "DynamicTree", 3);
+
+    SweepAndPrune sweep;
+    checkBroadphase(sweep, "SweepAndPrune", 4);
+    checkEvents(5);
+
+    checkStaticBVH(6);
+
+    JobSystem jobs(4);
+    LinearBVH serial;
+    LinearBVH parallel(&jobs);
+    checkBroadphase(serial, "LinearBVH", 7);
+    checkBroadphase(parallel, "parallel LinearBVH", 8);
+
+    LooseQuadtree quadtree(vec2(-16.0f, -16.0f), vec2(16.0f, 16.0f), 6);
+    checkBroadphase(quadtree, "LooseQuadtree", 9);
+
+    HierarchicalGrid hierarchical(0.5f, 6, 256);
+    checkBroadphase(hierarchical, "HierarchicalGrid", 10);
+
+    if (failures > 0) {return 1;}
+    std::printf("every broadphase agrees with brute force\n");
+    return 0;
+
+}
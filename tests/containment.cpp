@@ -0,0 +1,108 @@
+#include <cmath>
+#include <cstdio>
+#include "collision.hpp"
+
+namespace {
+
+    int failures = 0;
+
+    void check(bool passed, const char* what) {
+        if (passed) {return;}
+        std::printf("failed: %s\n", what);
+        failures++;
+    }
+
+    bool near(vec2 a, vec2 b) {
+        return fabsf(a.x - b.x) < 1e-5f && fabsf(a.y - b.y) < 1e-5f;
+    }
+
+    /*
+    A small circle lies wholly inside the triangle, nearest to the edge along the x axis, which is
+    the edge opposite the vertex named by opposite. It reaches none of the edges, so only the
+    containment test can find it.
+    */
+    void checkInside(Triangle triangle, unsigned int opposite) {
+
+        Circle circle = Circle(0.25f, vec2(1.0f, 0.6f));
+        TriangleCache cache = TriangleCache(triangle);
+        ShapeRef circleRef = ShapeRef(&circle);
+        ShapeRef triangleRef = ShapeRef(&triangle);
+
+        check(overlaps(circle, triangle), "overlaps(Circle, Triangle)");
+        check(overlaps(triangle, circle), "overlaps(Triangle, Circle)");
+        check(overlaps(circle, cache), "overlaps(Circle, TriangleCache)");
+        check(overlaps(circleRef, triangleRef), "overlaps(ShapeRef, ShapeRef)");
+
+        // The circle is pushed out through the nearest edge, by the distance to it plus the radius.
+        CollisionResult result = getCollision(circle, triangle);
+        check(result.colliding, "getCollision(Circle, Triangle) collides");
+        check(near(result.normal, vec2(0.0f, -1.0f)), "normal points out of the nearest edge");
+        check(fabsf(result.depth - 0.425f) < 1e-5f, "depth is half of the distance plus the radius");
+        check(near(result.point, vec2(1.0f, 0.425f)), "point lies depth inside the nearest edge");
+        check(result.feature == (FEATURE_EDGE | opposite) << 8, "feature names the nearest edge");
+
+        CollisionResult flipped = getCollision(triangle, circle);
+        check(flipped.colliding && near(flipped.normal, vec2(0.0f, 1.0f)), "getCollision(Triangle, Circle) flips the normal");
+        check(flipped.feature == (FEATURE_EDGE | opposite), "getCollision(Triangle, Circle) flips the feature");
+
+        CollisionResult cached = getCollision(circle, cache);
+        check(cached.colliding && cached.normal == result.normal && cached.depth == result.depth, "getCollision(Circle, TriangleCache) agrees");
+
+        CollisionResult tagged = getCollision(circleRef, triangleRef);
+        check(tagged.colliding && tagged.normal == result.normal && tagged.depth == result.depth, "getCollision(ShapeRef, ShapeRef) agrees");
+
+        // The SIMD kernel finds it too, in a full block of lanes and in the scalar remainder.
+        float x[9];
+        float y[9];
+        float radii[9];
+        for (int i = 0; i < 9; i++) {
+            x[i] = 20.0f;
+            y[i] = 20.0f;
+            radii[i] = 0.25f;
+        }
+
+        const int slots[] = {1, 8};
+        for (int slot : slots) {
+
+            x[slot] = circle.centre.x;
+            y[slot] = circle.centre.y;
+
+            CollisionResult results[9];
+            int indices[9];
+            int count = getCollisions(x, y, radii, 9, triangle, results, indices);
+            check(count == 1 && indices[0] == slot, "SIMD getCollisions finds the circle inside");
+            check(count == 1 && near(results[0].normal, result.normal) && fabsf(results[0].depth - result.depth) < 1e-5f, "SIMD getCollisions agrees");
+            check(count == 1 && results[0].feature == result.feature, "SIMD getCollisions names the same edge");
+
+            x[slot] = 20.0f;
+            y[slot] = 20.0f;
+
+        }
+
+    }
+
+}
+
+/*
+Checks that a circle with its centre inside a triangle collides with it, for trigger volumes
+and for fast circles that step past an edge in one go, with the triangle wound either way.
+*/
+int main() {
+
+    checkInside(Triangle(vec2(0.0f, 0.0f), vec2(4.0f, 0.0f), vec2(0.0f, 4.0f)), 2);
+    checkInside(Triangle(vec2(0.0f, 0.0f), vec2(0.0f, 4.0f), vec2(4.0f, 0.0f)), 1);
+
+    // A circle that fits in the corner between two edges is still pushed through the nearer one.
+    Triangle triangle = Triangle(vec2(0.0f, 0.0f), vec2(4.0f, 0.0f), vec2(0.0f, 4.0f));
+    CollisionResult corner = getCollision(Circle(0.3f, vec2(0.4f, 0.2f)), triangle);
+    check(corner.colliding && near(corner.normal, vec2(0.0f, -1.0f)), "a centre near a corner leaves through the nearer edge");
+
+    // Circles outside the triangle are unaffected.
+    check(!overlaps(Circle(0.25f, vec2(3.0f, 3.0f)), triangle), "a circle past the long edge does not overlap");
+    check(!getCollision(Circle(0.25f, vec2(-1.0f, 1.0f)), triangle).colliding, "a circle left of the triangle does not collide");
+
+    if (failures > 0) {return 1;}
+    std::printf("circles inside triangles collide\n");
+    return 0;
+
+}
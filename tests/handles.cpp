@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <vector>
+#include "grid.hpp"
+#include "world.hpp"
+
+namespace {
+
+    const int INDEX_BITS = 22;
+    const int GENERATIONS = 1 << (32 - INDEX_BITS);
+
+}
+
+/*
+Reuses one slot until its generation is used up, checking that no old handle ever becomes valid
+again, then fills the slot table and checks that adding fails cleanly.
+*/
+int main() {
+
+    Grid grid(1.0f, 1024);
+    World world(&grid);
+
+    // Removed slots are reused after the next collide, with the next generation.
+    std::vector<Handle> removed;
+    Handle handle = world.add(Circle(0.5f, vec2(0.0f, 0.0f)));
+    int slot = world.getSlot(handle);
+
+    for (int reuse = 0; reuse < GENERATIONS - 1; reuse++) {
+
+        world.remove(handle);
+        removed.push_back(handle);
+        world.collide();
+
+        handle = world.add(Circle(0.5f, vec2(0.0f, 0.0f)));
+        if (world.getSlot(handle) != slot) {
+            std::printf("slot %d was not reused after %d reuses\n", slot, reuse);
+            return 1;
+        }
+
+    }
+
+    // The last generation is used up, so the slot is retired and the next shape gets a new one.
+    world.remove(handle);
+    removed.push_back(handle);
+    world.collide();
+    handle = world.add(Circle(0.5f, vec2(0.0f, 0.0f)));
+
+    if (world.getSlot(handle) == slot) {
+        std::printf("slot %d was reused past its last generation\n", slot);
+        return 1;
+    }
+
+    for (Handle old : removed) {
+        if (world.contains(old)) {
+            std::printf("the removed handle %x is valid again\n", old);
+            return 1;
+        }
+    }
+
+    // Fill every slot, after which adding fails without touching the world.
+    int added = world.getCircleCount();
+    while (true) {
+        Handle next = world.add(Circle(0.5f, vec2(0.0f, 0.0f)));
+        if (next == INVALID_HANDLE) {break;}
+        added++;
+    }
+
+    // One slot is retired, and the last index is left unused so that INVALID_HANDLE never names a slot.
+    if (added != (1 << INDEX_BITS) - 2 || world.getCircleCount() != added || world.contains(INVALID_HANDLE)) {
+        std::printf("the slot table filled up after %d shapes\n", added);
+        return 1;
+    }
+
+    std::printf("%d reuses of a slot and %d shapes without a stale handle\n", GENERATIONS - 1, added);
+    return 0;
+
+}
@@ -0,0 +1,100 @@
+#include <atomic>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include "jobs.hpp"
+
+namespace {
+
+    int failures = 0;
+
+    void fail(const char* what, int threads, int n, int grain) {
+        std::printf("failed: %s with %d threads, n = %d, grain = %d\n", what, threads, n, grain);
+        failures++;
+    }
+
+    // Runs parallelFor over [0, n) and checks that every index is visited exactly once, by chunks
+    // on the fixed boundaries.
+    void checkCoverage(JobSystem& jobs, int threads, int n, int grain) {
+
+        std::vector<std::atomic<int>> visits(std::max(n, 0));
+        for (std::atomic<int>& visit : visits) {visit = 0;}
+        std::atomic<int> misplaced(0);
+
+        jobs.parallelFor(n, grain, [&](int begin, int end) {
+            if (begin % grain != 0 || end != std::min(begin + grain, n)) {misplaced++;}
+            for (int i = begin; i < end; i++) {visits[i]++;}
+        });
+
+        if (misplaced > 0) {fail("chunk boundaries moved", threads, n, grain);}
+        for (int i = 0; i < n; i++) {
+            if (visits[i] != 1) {
+                fail("an index was not visited exactly once", threads, n, grain);
+                return;
+            }
+        }
+
+    }
+
+    // Starts a parallelFor from inside every chunk of another, and checks every pair of indices.
+    void checkNested(JobSystem& jobs, int threads, int outer, int inner) {
+
+        std::vector<std::atomic<int>> visits(outer * inner);
+        for (std::atomic<int>& visit : visits) {visit = 0;}
+
+        jobs.parallelFor(outer, 1, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                jobs.parallelFor(inner, 3, [&, i](int first, int last) {
+                    for (int j = first; j < last; j++) {visits[i * inner + j]++;}
+                });
+            }
+        });
+
+        for (int k = 0; k < outer * inner; k++) {
+            if (visits[k] != 1) {
+                fail("a nested index was not visited exactly once", threads, outer * inner, 3);
+                return;
+            }
+        }
+
+    }
+
+}
+
+/*
+Checks that parallelFor visits every index exactly once across sizes, grains and thread counts,
+including a system of one thread, which starts no workers, and empty ranges, and that jobs can
+start other jobs. The suite is also meant to be run under ThreadSanitizer (the TRIP2D_TSAN option).
+*/
+int main() {
+
+    const int threadCounts[] = {0, 1, 2, 4, 7};
+    const int sizes[] = {-1, 0, 1, 2, 7, 64, 1000, 4097};
+    const int grains[] = {1, 3, 64, 1000, 5000};
+
+    for (int threads : threadCounts) {
+
+        JobSystem jobs(threads);
+        if (jobs.getThreadCount() != std::max(threads, 1)) {fail("wrong thread count", threads, 0, 0);}
+
+        for (int n : sizes) {
+            for (int grain : grains) {checkCoverage(jobs, threads, n, grain);}
+        }
+
+        // A grain below one is taken as one.
+        std::atomic<int> calls(0);
+        jobs.parallelFor(5, 0, [&](int begin, int end) {calls += end - begin == 1 ? 1 : 100;});
+        if (calls != 5) {fail("a grain of zero did not run one index per chunk", threads, 5, 0);}
+
+        checkNested(jobs, threads, 16, 50);
+
+        // Many small jobs in a row, so workers fall asleep and wake between them.
+        for (int round = 0; round < 200; round++) {checkCoverage(jobs, threads, 17, 2);}
+
+    }
+
+    if (failures > 0) {return 1;}
+    std::printf("parallelFor visited every index exactly once\n");
+    return 0;
+
+}
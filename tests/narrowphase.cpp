@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <vector>
+#include "allocations.hpp"
+#include "collision.hpp"
+
+/*
+Sweeps circles and triangles of both windings past each other and checks that no narrowphase
+entry point allocates, including the batched and SIMD overloads.
+*/
+int main() {
+
+    std::vector<Circle> circles;
+    std::vector<Triangle> triangles;
+
+    for (int i = 0; i < 64; i++) {
+
+        vec2 position = vec2(0.25f * (i % 8), 0.25f * (i / 8));
+        circles.push_back(Circle(0.3f + 0.05f * (i % 3), position));
+
+        Triangle triangle = i % 2 == 0
+            ? Triangle(position, position + vec2(0.6f, 0.0f), position + vec2(0.3f, 0.5f))
+            : Triangle(position, position + vec2(0.3f, 0.5f), position + vec2(0.6f, 0.0f));
+        triangle.rotate(Rotation(11.0f * i), triangle.centroid());
+        triangles.push_back(triangle);
+
+    }
+
+    int n = circles.size();
+    std::vector<Circle> otherCircles(circles.rbegin(), circles.rend());
+    std::vector<Triangle> otherTriangles(triangles.rbegin(), triangles.rend());
+    std::vector<TriangleCache> caches(triangles.begin(), triangles.end());
+    std::vector<TriangleCache> otherCaches(otherTriangles.begin(), otherTriangles.end());
+    std::vector<float> x, y, radii;
+    for (const Circle& circle : circles) {
+        x.push_back(circle.centre.x);
+        y.push_back(circle.centre.y);
+        radii.push_back(circle.radius);
+    }
+
+    std::vector<CollisionResult> results(n);
+    std::vector<int> indices(n);
+    long colliding = 0;
+
+    allocations::start();
+
+    for (int i = 0; i < n; i++) {
+
+        Circle& circle = circles[i];
+        Triangle& triangle = triangles[i];
+        ShapeRef circleRef = ShapeRef(&circle);
+        ShapeRef triangleRef = ShapeRef(&triangle);
+
+        for (int j = 0; j < n; j++) {
+
+            ShapeRef otherCircle = ShapeRef(&otherCircles[j]);
+            ShapeRef otherTriangle = ShapeRef(&otherTriangles[j]);
+
+            colliding += getCollision(circle, otherCircles[j]).colliding;
+            colliding += getCollision(triangle, otherTriangles[j]).colliding;
+            colliding += getCollision(circle, otherTriangles[j]).colliding;
+            colliding += getCollision(triangle, otherCircles[j]).colliding;
+            colliding += getCollision(circleRef, otherTriangle).colliding;
+            colliding += getCollision(triangleRef, otherCircle).colliding;
+            colliding += getCollision(caches[i], otherCaches[j]).colliding;
+            colliding += getCollision(circle, otherCaches[j]).colliding;
+
+            colliding += overlaps(circle, otherCircles[j]);
+            colliding += overlaps(triangle, otherTriangles[j]);
+            colliding += overlaps(circle, otherTriangles[j]);
+            colliding += overlaps(triangle, otherCircles[j]);
+            colliding += overlaps(circleRef, otherTriangle);
+            colliding += overlaps(caches[i], otherCaches[j]);
+            colliding += overlaps(circle, otherCaches[j]);
+
+        }
+
+        colliding += getCollisions(x.data(), y.data(), radii.data(), n, circle, results.data(), indices.data());
+        colliding += getCollisions(x.data(), y.data(), radii.data(), n, triangle, results.data(), indices.data());
+        colliding += getCollisions(x.data(), y.data(), radii.data(), n, caches[i], results.data(), indices.data());
+
+    }
+
+    colliding += getCollisions(circles.data(), otherCircles.data(), n, results.data(), indices.data());
+    colliding += getCollisions(triangles.data(), otherTriangles.data(), n, results.data(), indices.data());
+    colliding += getCollisions(circles.data(), otherTriangles.data(), n, results.data(), indices.data());
+
+    long count = allocations::stop();
+
+    if (colliding == 0) {
+        std::printf("sweep found no collisions\n");
+        return 1;
+    }
+
+    if (count != 0) {
+        std::printf("narrowphase allocated %ld times\n", count);
+        return 1;
+    }
+
+    std::printf("narrowphase made no allocations over %ld collisions\n", colliding);
+    return 0;
+
+}
@@ -0,0 +1,213 @@
+#include <cstdio>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include "pairs.hpp"
+
+namespace {
+
+    typedef std::set<std::pair<int, int>> PairSet;
+
+    const int IDS = 48;
+    const int OPERATIONS = 200000;
+
+    int failures = 0;
+
+    void fail(const char* what, int operation) {
+        std::printf("failed: %s after operation %d\n", what, operation);
+        failures++;
+    }
+
+    // Tags a pair's result, so the test can tell whether its entries moved along with it.
+    unsigned int getTag(int a, int b) {
+        return a * IDS + b + 1;
+    }
+
+    void append(PairSet& events, const std::vector<Pair>& pairs) {
+        for (Pair pair : pairs) {events.insert({pair.a, pair.b});}
+    }
+
+    /*
+    Compares the whole manager with the model: the pairs, which of them are awake, that find gives
+    every pair's index, and that the tagged results moved with their pairs through every swap.
+    */
+    void checkAll(const PairManager& manager, const PairSet& all, const PairSet& awake, int operation) {
+
+        if (manager.pairs.size() != all.size() || manager.results.size() != all.size() || manager.impulses.size() != all.size()) {
+            fail("the pair count disagrees with the model", operation);
+            return;
+        }
+
+        if (manager.getAwakeCount() != (int) awake.size()) {fail("the awake count disagrees with the model", operation);}
+
+        for (int i = 0; i < (int) manager.pairs.size(); i++) {
+
+            Pair pair = manager.pairs[i];
+            bool isAwake = i < manager.getAwakeCount();
+
+            if (pair.a >= pair.b || all.count({pair.a, pair.b}) == 0) {fail("the manager holds a pair the model does not", operation);}
+            if (isAwake != (awake.count({pair.a, pair.b}) != 0)) {fail("a pair is in the wrong awake or sleeping range", operation);}
+            if (manager.find(pair.a, pair.b) != i || manager.find(pair.b, pair.a) != i) {fail("find lost a pair", operation);}
+            if (manager.results[i].feature != getTag(pair.a, pair.b)) {fail("a pair's result did not move with it", operation);}
+
+        }
+
+        for (int a = 0; a < IDS; a++) {
+            for (int b = a + 1; b < IDS; b++) {
+                if (all.count({a, b}) == 0 && manager.find(a, b) != -1) {fail("find reported a removed pair", operation);}
+            }
+        }
+
+    }
+
+    bool same(const CollisionResult& a, const CollisionResult& b) {
+        return a.colliding == b.colliding && a.normal == b.normal && a.point == b.point && a.depth == b.depth && a.feature == b.feature;
+    }
+
+    /*
+    Checks that collide reuses a stored result only when both shapes have moved by the same
+    translation. The stored result is marked with a depth no narrowphase gives, so a reused result
+    keeps the mark and a recomputed one matches getCollision. Coordinates are multiples of an
+    eighth, so the translations are exact and a tolerance of zero can be used.
+    */
+    void checkMemo() {
+
+        Circle circle = Circle(0.5f, vec2(0.25f, 0.625f));
+        Triangle triangle = Triangle(vec2(-1.0f, 0.0f), vec2(1.0f, 0.0f), vec2(0.0f, 1.0f));
+        ShapeRef shapes[2] = {ShapeRef(&circle), ShapeRef(&triangle)};
+
+        PairManager manager;
+        manager.add(0, 1);
+
+        auto collide = [&](float tolerance) {
+            manager.collide(shapes, tolerance);
+            return manager.results[0];
+        };
+
+        auto mark = [&]() {
+            manager.results[0].depth = -1.0f;
+        };
+
+        if (!same(collide(0.0f), getCollision(shapes[0], shapes[1])) || !manager.results[0].colliding) {fail("the first collide is wrong", 0);}
+
+        // Unmoved, and then moved together, the marked result is kept and carried along.
+        mark();
+        vec2 point = manager.results[0].point;
+        if (collide(0.0f).depth != -1.0f) {fail("a result was not reused for unmoved shapes", 1);}
+
+        vec2 offset = vec2(0.25f, -0.5f);
+        circle.translate(offset);
+        triangle.translate(offset);
+        CollisionResult moved = collide(0.0f);
+        if (moved.depth != -1.0f || moved.point != point + offset) {fail("a result was not reused and moved for a shared translation", 2);}
+
+        // Moving one shape alone drops it.
+        circle.translate(vec2(0.125f, 0.0f));
+        if (!same(collide(0.0f), getCollision(shapes[0], shapes[1]))) {fail("a result was reused after one shape moved", 3);}
+
+        // Rotating both about the same point keeps their relative pose, but not their contact, so it drops it.
+        mark();
+        circle.rotate(30.0f, vec2(0.0f, 0.0f));
+        triangle.rotate(30.0f, vec2(0.0f, 0.0f));
+        if (!same(collide(0.0f), getCollision(shapes[0], shapes[1]))) {fail("a result was reused after both shapes rotated", 4);}
+
+        // Rotating the circle on its own centre changes nothing the narrowphase sees, so the result is kept.
+        mark();
+        circle.rotate(45.0f, circle.centre);
+        if (collide(0.0f).depth != -1.0f) {fail("a result was not reused after a circle turned in place", 5);}
+
+        // With a tolerance, translations that differ by less than it still count as shared.
+        mark();
+        circle.translate(vec2(0.5f, 0.0f));
+        triangle.translate(vec2(0.5f, 0.004f));
+        if (collide(0.01f).depth != -1.0f) {fail("a result was not reused within the tolerance", 6);}
+        circle.translate(vec2(0.5f, 0.0f));
+        triangle.translate(vec2(0.5f, 0.02f));
+        if (!same(collide(0.01f), getCollision(shapes[0], shapes[1]))) {fail("a result was reused past the tolerance", 7);}
+
+    }
+
+}
+
+/*
+Runs random adds, removes, sleeps and wakes on a PairManager and checks it against a set model.
+The ids are few, so the hash table fills up, grows and has long probe sequences for the
+backward shift delete to repair. Also checks the begun and ended events against the pairs
+added and removed since they were last cleared, and when collide reuses a stored result.
+*/
+int main() {
+
+    std::mt19937 rng(16);
+    PairManager manager;
+    PairSet all, awake, begun, ended;
+
+    for (int operation = 0; operation < OPERATIONS; operation++) {
+
+        int a = rng() % IDS;
+        int b = rng() % IDS;
+        if (a == b) {continue;}
+        std::pair<int, int> key = {std::min(a, b), std::max(a, b)};
+
+        // Lean towards adding while the table is small and removing once it is large.
+        int roll = rng() % 8;
+        bool grow = (int) all.size() < (operation / 20000 % 2 == 0 ? 900 : 100);
+
+        if (roll < (grow ? 4 : 2)) {
+            bool added = all.insert(key).second;
+            if (manager.add(a, b) != added) {fail("add disagrees with the model", operation);}
+            if (added) {
+                awake.insert(key);
+                begun.insert(key);
+                manager.results[manager.find(a, b)].feature = getTag(key.first, key.second);
+            }
+        }
+
+        else if (roll < 6) {
+            bool removed = all.erase(key) != 0;
+            if (manager.remove(a, b) != removed) {fail("remove disagrees with the model", operation);}
+            if (removed) {
+                awake.erase(key);
+                ended.insert(key);
+            }
+        }
+
+        else if (!all.empty()) {
+            int index = rng() % all.size();
+            Pair pair = manager.pairs[index];
+            if (roll == 6) {
+                manager.sleep(index);
+                awake.erase({pair.a, pair.b});
+            }
+            else {
+                manager.wake(index);
+                awake.insert({pair.a, pair.b});
+            }
+        }
+
+        if (operation % 97 == 0) {checkAll(manager, all, awake, operation);}
+
+        // Compare the events every few operations, as sets, since a pair can begin and end in between.
+        if (operation % 5 == 0) {
+            PairSet reportedBegun, reportedEnded;
+            append(reportedBegun, manager.begun);
+            append(reportedEnded, manager.ended);
+            if (reportedBegun != begun || reportedEnded != ended) {fail("the events disagree with the model", operation);}
+            manager.clearEvents();
+            begun.clear();
+            ended.clear();
+        }
+
+        if (failures > 0) {return 1;}
+
+    }
+
+    checkAll(manager, all, awake, OPERATIONS);
+    checkMemo();
+    if (failures > 0) {return 1;}
+
+    std::printf("%d pair manager operations agree with the model\n", OPERATIONS);
+    return 0;
+
+}
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "collision.hpp"
+#include "simd.hpp"
+
+#ifdef TRIP2D_LANES
+const int LANES = TRIP2D_LANES;
+#else
+const int LANES = 1;
+#endif
+
+namespace {
+
+    int failures = 0;
+
+    bool close(float a, float b) {
+        return fabsf(a - b) <= 1e-5f * std::max(1.0f, fabsf(b));
+    }
+
+    bool agrees(const CollisionResult& a, const CollisionResult& b) {
+        return a.colliding == b.colliding && a.feature == b.feature && close(a.depth, b.depth)
+            && close(a.normal.x, b.normal.x) && close(a.normal.y, b.normal.y)
+            && close(a.point.x, b.point.x) && close(a.point.y, b.point.y);
+    }
+
+    // Compares the compacted output of a SIMD kernel with the scalar kernel run on each circle in turn.
+    template <typename Shape>
+    void compare(const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& radii, int n, const Shape& shape, const char* name) {
+
+        std::vector<CollisionResult> results(n + 1);
+        std::vector<int> indices(n + 1);
+        int count = getCollisions(x.data(), y.data(), radii.data(), n, shape, results.data(), indices.data());
+
+        int k = 0;
+        for (int i = 0; i < n; i++) {
+
+            CollisionResult expected = getCollision(Circle(radii[i], vec2(x[i], y[i])), shape);
+            if (!expected.colliding) {continue;}
+
+            if (k >= count || indices[k] != i || !agrees(results[k], expected)) {
+                std::printf("failed: %s disagrees with the scalar kernel at circle %d of %d\n", name, i, n);
+                failures++;
+                return;
+            }
+            k++;
+
+        }
+
+        if (k != count) {
+            std::printf("failed: %s found %d collisions where the scalar kernel found %d, n = %d\n", name, count, k, n);
+            failures++;
+        }
+
+    }
+
+}
+
+/*
+Checks that the SIMD circle kernels give the same results as the scalar getCollision overloads,
+over every count up to a few blocks of lanes, so that the scalar remainder is covered, and over
+a large random batch. Build with TRIP2D_AVX2 to cover the AVX2 lanes.
+*/
+int main() {
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> radius(0.05f, 1.5f);
+
+    const int total = 4096;
+    std::vector<float> x(total), y(total), radii(total);
+    for (int i = 0; i < total; i++) {
+        x[i] = position(rng);
+        y[i] = position(rng);
+        radii[i] = radius(rng);
+    }
+
+    Circle circle = Circle(1.2f, vec2(0.3f, -0.2f));
+    Triangle counterClockwise = Triangle(vec2(-1.5f, -1.0f), vec2(2.0f, -0.5f), vec2(0.0f, 2.0f));
+    Triangle clockwise = Triangle(vec2(-1.5f, -1.0f), vec2(0.0f, 2.0f), vec2(2.0f, -0.5f));
+    TriangleCache cache = TriangleCache(counterClockwise);
+
+    for (int n = 0; n <= 4 * LANES + 3; n++) {
+        compare(x, y, radii, n, circle, "circles against a circle");
+        compare(x, y, radii, n, counterClockwise, "circles against a counter-clockwise triangle");
+        compare(x, y, radii, n, clockwise, "circles against a clockwise triangle");
+        compare(x, y, radii, n, cache, "circles against a cached triangle");
+    }
+
+    compare(x, y, radii, total - 1, circle, "circles against a circle");
+    compare(x, y, radii, total - 1, counterClockwise, "circles against a counter-clockwise triangle");
+    compare(x, y, radii, total - 1, clockwise, "circles against a clockwise triangle");
+
+    if (failures > 0) {return 1;}
+    std::printf("SIMD kernels with %d lanes agree with the scalar kernels\n", LANES);
+    return 0;
+
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include "tree.hpp"
+#include "physics.hpp"
+
+namespace {
+
+    const int MOVING = 64;
+    const int STEPS = 100;
+
+    struct Cost {
+        double seconds;
+        int awake;
+        int awakePairs;
+    };
+
+    double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /*
+    Builds a square pile of touching circles with no gravity, lets it fall asleep, then times steps
+    of rows of touching circles moving past it. Only the moving circles should cost anything.
+    */
+    Cost measure(int side) {
+
+        // The tree updates only the proxies that move, where the grids rebuild from every proxy.
+        DynamicTree tree(0.1f);
+        Physics physics(&tree, 8);
+
+        for (int row = 0; row < side; row++) {
+            for (int col = 0; col < side; col++) {physics.add(Circle(0.5f, vec2(col, row)), 1.0f);}
+        }
+
+        std::vector<Handle> moving;
+        for (int i = 0; i < MOVING; i++) {
+            moving.push_back(physics.add(Circle(0.5f, vec2(-10.0f - (i % 8), 2.0f * (i / 8))), 1.0f));
+        }
+
+        // The pile falls asleep after sleepDelay, while the moving circles never slow down.
+        for (Handle handle : moving) {physics.setVelocity(handle, vec2(0.0f, -1.0f));}
+        for (int step = 0; step < 60; step++) {physics.step(1.0f / 60.0f);}
+
+        double best = 1e9;
+        for (int run = 0; run < 3; run++) {
+            double start = now();
+            for (int step = 0; step < STEPS; step++) {physics.step(1.0f / 60.0f);}
+            best = std::min(best, (now() - start) / STEPS);
+        }
+
+        return {best, physics.getAwakeCount(), physics.world.pairs.getAwakeCount()};
+
+    }
+
+}
+
+int main() {
+
+    const int sides[] = {32, 64, 128};
+    Cost costs[3];
+
+    for (int i = 0; i < 3; i++) {
+        costs[i] = measure(sides[i]);
+        std::printf("%d sleeping circles: %.4f ms per step, %d awake bodies, %d awake pairs\n", sides[i] * sides[i], costs[i].seconds * 1e3, costs[i].awake, costs[i].awakePairs);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        if (costs[i].awake != MOVING || costs[i].awakePairs != costs[0].awakePairs) {
+            std::printf("the pile did not fall asleep\n");
+            return 1;
+        }
+    }
+
+    // Sixteen times the sleeping circles should leave the cost of a step about where it was.
+    if (costs[2].seconds > 2.0 * costs[0].seconds + 5e-6) {
+        std::printf("step cost grew with the sleeping pile\n");
+        return 1;
+    }
+
+    return 0;
+
+}
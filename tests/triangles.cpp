@@ -0,0 +1,145 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <algorithm>
+#include "collision.hpp"
+
+namespace {
+
+    const int PAIRS = 200000;
+
+    // Pairs whose reference overlap is this close to zero are touching, and either answer is right.
+    const float TOUCHING = 1e-4f;
+
+    float cross(vec2 a, vec2 b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    bool inside(vec2 p, const Triangle& t) {
+        float ab = cross(t.b - t.a, p - t.a);
+        float bc = cross(t.c - t.b, p - t.b);
+        float ca = cross(t.a - t.c, p - t.c);
+        return (ab > 0.0f && bc > 0.0f && ca > 0.0f) || (ab < 0.0f && bc < 0.0f && ca < 0.0f);
+    }
+
+    bool crosses(vec2 p, vec2 q, vec2 r, vec2 s) {
+        float d1 = cross(q - p, r - p);
+        float d2 = cross(q - p, s - p);
+        float d3 = cross(s - r, p - r);
+        float d4 = cross(s - r, q - r);
+        return ((d1 > 0.0f) != (d2 > 0.0f)) && ((d3 > 0.0f) != (d4 > 0.0f));
+    }
+
+    // Reference overlap test, without separating axes: a vertex inside the other triangle, or two crossing edges.
+    bool intersects(const Triangle& a, const Triangle& b) {
+
+        const vec2 va[3] = {a.a, a.b, a.c};
+        const vec2 vb[3] = {b.a, b.b, b.c};
+
+        for (int i = 0; i < 3; i++) {
+            if (inside(va[i], b) || inside(vb[i], a)) {return true;}
+        }
+
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                if (crosses(va[i], va[(i + 1) % 3], vb[j], vb[(j + 1) % 3])) {return true;}
+            }
+        }
+
+        return false;
+
+    }
+
+    // The smallest overlap of both triangles' projections on any of their six edge normals, taken
+    // from both ends of each axis. This is the distance either triangle must move to separate them,
+    // and is negative when an axis already separates them.
+    float getOverlap(const Triangle& a, const Triangle& b) {
+
+        const vec2 va[3] = {a.a, a.b, a.c};
+        const vec2 vb[3] = {b.a, b.b, b.c};
+        float overlap = INFINITY;
+
+        for (int k = 0; k < 6; k++) {
+
+            const vec2* v = k < 3 ? va : vb;
+            vec2 edge = v[(k + 1) % 3] - v[k % 3];
+            vec2 axis = glm::normalize(vec2(-edge.y, edge.x));
+
+            float minA = INFINITY, maxA = -INFINITY, minB = INFINITY, maxB = -INFINITY;
+            for (int i = 0; i < 3; i++) {
+                minA = std::min(minA, glm::dot(va[i], axis));
+                maxA = std::max(maxA, glm::dot(va[i], axis));
+                minB = std::min(minB, glm::dot(vb[i], axis));
+                maxB = std::max(maxB, glm::dot(vb[i], axis));
+            }
+
+            overlap = std::min(overlap, std::min(maxA - minB, maxB - minA));
+
+        }
+
+        return overlap;
+
+    }
+
+}
+
+/*
+Checks the separating axis triangle-triangle narrowphase over random pairs of both windings.
+The colliding flag must agree with an edge crossing and containment test, the depth must be half
+of the smallest overlap over the six edge normals, and moving A along the normal by twice the
+depth must separate the pair.
+*/
+int main() {
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> offset(-0.8f, 0.8f);
+
+    auto randomTriangle = [&]() {
+        vec2 centre = vec2(position(rng), position(rng));
+        while (true) {
+            Triangle t = Triangle(centre + vec2(offset(rng), offset(rng)), centre + vec2(offset(rng), offset(rng)), centre + vec2(offset(rng), offset(rng)));
+            if (fabsf(cross(t.b - t.a, t.c - t.a)) > 0.01f) {return t;}
+        }
+    };
+
+    int colliding = 0;
+    int flags = 0;
+    int depths = 0;
+    int separations = 0;
+
+    for (int i = 0; i < PAIRS; i++) {
+
+        Triangle a = randomTriangle();
+        Triangle b = randomTriangle();
+        CollisionResult result = getCollision(a, b);
+        float overlap = getOverlap(a, b);
+
+        if (fabsf(overlap) < TOUCHING) {continue;}
+        if (result.colliding != intersects(a, b) || result.colliding != (overlap > 0.0f)) {flags++;}
+        if (!result.colliding) {continue;}
+        colliding++;
+
+        if (fabsf(result.depth - overlap * 0.5f) > 1e-4f) {depths++;}
+
+        // The normal points from B towards A, so A leaves along it.
+        Triangle moved = a;
+        moved.translate(result.normal * (2.0f * result.depth + TOUCHING));
+        if (getCollision(moved, b).colliding || getOverlap(moved, b) > TOUCHING) {separations++;}
+
+    }
+
+    if (colliding < PAIRS / 10) {
+        std::printf("only %d of %d pairs collided\n", colliding, PAIRS);
+        return 1;
+    }
+
+    if (flags + depths + separations > 0) {
+        std::printf("%d wrong colliding flags, %d wrong depths and %d pairs left overlapping\n", flags, depths, separations);
+        return 1;
+    }
+
+    std::printf("%d colliding triangle pairs out of %d agree with the reference\n", colliding, PAIRS);
+    return 0;
+
+}
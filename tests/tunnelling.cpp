@@ -0,0 +1,45 @@
+#include <cstdio>
+#include "tree.hpp"
+#include "physics.hpp"
+
+namespace {
+
+    /*
+    Drops a fast circle onto a thin static triangle. In one step its centre moves from above the
+    top edge to inside the triangle, without the circle touching any edge in between, so the
+    only contact it can get is from its centre being inside.
+    */
+    float drop(JobSystem* jobs) {
+
+        DynamicTree tree(0.1f);
+        Physics physics(&tree, 8, jobs);
+        physics.gravity = vec2(0.0f, -10.0f);
+
+        physics.add(Triangle(vec2(-10.0f, 0.0f), vec2(10.0f, 0.0f), vec2(0.0f, -0.6f)), 0.0f);
+        Handle circle = physics.add(Circle(0.2f, vec2(0.0f, 0.9f)), 1.0f);
+        physics.setVelocity(circle, vec2(0.0f, -30.0f));
+
+        for (int step = 0; step < 120; step++) {physics.step(1.0f / 60.0f);}
+        return physics.getCentre(circle).y;
+
+    }
+
+}
+
+int main() {
+
+    JobSystem jobs(4);
+    float heights[] = {drop(nullptr), drop(&jobs)};
+
+    // The circle should come to rest on the top edge, with its centre a radius above it.
+    for (float y : heights) {
+        if (y < 0.15f || y > 0.25f) {
+            std::printf("the circle ended at y = %f instead of resting on the triangle\n", y);
+            return 1;
+        }
+    }
+
+    std::printf("the circle came to rest at y = %f\n", heights[0]);
+    return 0;
+
+}
@@ -1,4 +1,16 @@
 #pragma once
 
 #include "include/primitives.hpp"
-#include "include/collision.hpp"
\ No newline at end of file
+#include "include/collision.hpp"
+#include "include/broadphase.hpp"
+#include "include/grid.hpp"
+#include "include/tree.hpp"
+#include "include/sweep.hpp"
+#include "include/bvh.hpp"
+#include "include/lbvh.hpp"
+#include "include/quadtree.hpp"
+#include "include/hgrid.hpp"
+#include "include/pairs.hpp"
+#include "include/world.hpp"
+#include "include/physics.hpp"
+#include "include/jobs.hpp"
\ No newline at end of file